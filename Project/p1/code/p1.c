@@ -1,21 +1,138 @@
 /**
 * This script searches the solution for an 8-puzzle problem through AI search techniques
-* The blank tile is represented by the tile with the number 9
+* The blank tile is represented by the tile with the number 0
 * The current search technique is a naive breadth first search
+* Board states are packed into a single machine word (see State below)
+* The board size is fixed at compile time: gcc -DN=4 builds the solver for the
+* 15-puzzle and -DN=5 for the 24-puzzle, the default is the 8-puzzle
+* Batch mode solves many start states on a pool of threads, build with -pthread
+* Built with -DP1_LIBRARY it has no main and serves as a library, see p1.h
 */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
 #include <math.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "p1.h"
 
 
+#ifndef N
 #define N 3         // NxN puzzle
+#endif
+#define NTILES (N*N)    // number of cells on the board
+#define BLANK 0         // value of the blank tile
 #define MAXVALIDMOVES 4  // maximum number valid moves (4 for the center tile)
+#ifndef SOLDEPTH
 #define SOLDEPTH 4   // actual depth of the solution
+#endif
+#ifndef MAX_DEPTH
+#if N == 3
 #define MAX_DEPTH 17   // Maximum depth of tree uptill which algorithm will search for solution
-#define _ff(w,g,h) w*g+(1-w)*h
-#define w 1
+#elif N == 4
+#define MAX_DEPTH 80   // every 15-puzzle instance is solvable in 80 moves
+#else
+#define MAX_DEPTH 208  // upper bound on the optimal solution length of the 24-puzzle
+#endif
+#endif
+#define MAX_SOLUTION_LENGTH 255    // longest path IDA* keeps track of
+#ifndef CLOSED_MAX_BYTES
+#define CLOSED_MAX_BYTES (512UL<<20)   // memory cap of the closed table, can be overridden at compile time
+#endif
+#define CLOSED_INITIAL_SIZE (1<<16)    // initial number of slots of the closed table
+#define HEURISTIC_MISPLACED 0      // number of misplaced tiles
+#define HEURISTIC_MANHATTAN 1      // sum of Manhattan distances
+#define NHEURISTICS 2              // heuristics that have per tile cost tables
+#define HEURISTIC_PDB 2            // additive pattern databases
+#define HEURISTIC_LINEAR 3         // Manhattan distance plus linear conflicts
+#define HEURISTIC_WALKING 4        // walking distance, boards of at most 4x4
+#define HEURISTIC_MAX 5            // maximum of linear, walking and pdb
+#define NSEARCHHEURISTICS 6        // heuristics that AStar and IDAStar can use
+#define LINECODES (N == 3 ? 64 : N == 4 ? 625 : 7776)     // (N+1)^N codes of the tiles of a line, see LineCode
+#define ALGORITHM_BFS 0            // search algorithms of Solve
+#define ALGORITHM_DFS 1
+#define ALGORITHM_GBEFS 2
+#define ALGORITHM_ASTAR 3
+#define ALGORITHM_IDASTAR 4
+#define ALGORITHM_HDASTAR 5
+#define ALGORITHM_PIDASTAR 6
+#define ALGORITHM_ORACLE 7
+#define ALGORITHM_BIBFS 8
+#define ALGORITHM_MM 9
+#define ALGORITHM_SMASTAR 10
+#define ALGORITHM_EXTBFS 11
+#define ALGORITHM_ARASTAR 12
+#define ALGORITHM_IDDFS 13
+#define NALGORITHMS 14
+#define SMA_NODE_BUDGET (1<<20)    // default number of nodes SMA* may keep
+#define SMA_HEAP_SLACK 4           // heap entries per node of the budget before stale ones are cleared out
+#define EXT_RUN_BYTES (64<<20)     // default buffer of external memory BFS, the size of its sorted runs
+#define EXT_IO_BUFFER (1<<20)      // stdio buffer of every file external memory BFS reads or writes
+#define SPILL_NAME_LENGTH 1024     // longest name of a file of external memory BFS
+#define ARA_WEIGHT 3.0             // default inflation of the heuristic in the first round of ARA*
+#define ARA_WEIGHT_STEP 0.5        // default decrease of the inflation between rounds of ARA*
+#define IDDFS_CACHE_ENTRIES (1<<18)    // default entries of the transposition cache of iterative deepening
+#define DEFAULT_SEARCH_SETTINGS {HEURISTIC_MANHATTAN, 1, 0, 0, SMA_NODE_BUDGET, ARA_WEIGHT, ARA_WEIGHT_STEP, \
+                                 IDDFS_CACHE_ENTRIES, NULL}     // initial struct SearchSettings of every thread
+#define IDDFS_CACHE_MIN_DEPTH 4    // fewest moves left to the depth limit for which the cache is used
+#define PIDA_UNITS_PER_THREAD 32   // work units per thread that parallel IDA* aims for
+#define PIDA_MAX_SPLIT_DEPTH 16    // deepest cut of the tree into work units
+#define PIDA_POLL_INTERVAL 1024    // nodes between two checks whether a sweep can stop
+#define PHASE_EXPAND 0             // phases of a search timed with -DPHASE_TIMERS
+#define PHASE_HEURISTIC 1
+#define PHASE_QUEUE 2
+#define PHASE_GOALTEST 3
+#define NPHASES 4
+#define STATS_TEXT 0               // output formats of the search statistics
+#define STATS_JSON 1
+#define STATS_CSV 2
+#define BUDGET_POLL_INTERVAL 1024  // nodes between two checks of the time and memory budget
+#define EIGHT_PUZZLE_MAX_LENGTH 31    // longest optimal solution of the 8-puzzle
+#define EIGHT_PUZZLE_STATES 181440    // configurations of the 8-puzzle that can reach the goal
+#define ORACLE_TABLE_BYTES (EIGHT_PUZZLE_STATES/2)   // distance oracle, a nibble per configuration
+#define BENCH_PER_DEPTH 5          // instances per solution length in the benchmark
+#define BENCH_15_MAX_LENGTH 20     // longest solution of the 15-puzzle benchmark, breadth first search still fits in memory
+#define BENCH_15_TRIES 1000        // random walks drawn for a 15-puzzle instance before giving up on it
+#define BENCH_SEED 1               // default seed of the benchmark instances
+#define BENCH_TIME_LIMIT 10        // default seconds a benchmark search may take
+#define BENCH_EXPANSION_TOLERANCE 1.10     // expansions above the baseline by more than this factor regress
+#define BENCH_TIME_TOLERANCE 1.50          // so do times, if also more than BENCH_TIME_SLACK seconds slower
+#define BENCH_TIME_SLACK 0.001
+#define BATCH_LINE_LENGTH 1024    // longest line of a batch file
+#define SERVER_LATENCY_SAMPLES 4096     // latest requests whose latencies make up the percentiles of the server
+#define SERVER_CONNECTIONS 64           // clients the server reads from at the same time
+#define ARENA_BLOCK_SIZE (1<<20)   // bytes requested from malloc at a time for nodes
+#define ARENA_ALIGN 16             // alignment of every arena allocation
+// The phase timers read the clock twice per call of the timed functions, which costs
+// more than some of them, so they are only compiled in with -DPHASE_TIMERS
+#ifdef PHASE_TIMERS
+#define PHASE_BEGIN(phase) (metrics.phase_start[phase] = NowNanoseconds())
+#define PHASE_END(phase) (metrics.phase_ns[phase] += NowNanoseconds() - metrics.phase_start[phase])
+#else
+#define PHASE_BEGIN(phase)
+#define PHASE_END(phase)
+#endif
+// errors loading a pattern database file, the library only reports them by its return value
+#ifdef P1_LIBRARY
+#define LOAD_ERROR(...) ((void)0)
+#else
+#define LOAD_ERROR(...) fprintf(stderr, __VA_ARGS__)
+#endif
+#define _ff(w,g,h) ((w)*(g)+(1-(w))*(h))     // f value with weight w on g and 1-w on h, used by ARA*
 
 typedef struct      // coordinates of a single tile
 {
@@ -23,9 +140,38 @@ typedef struct      // coordinates of a single tile
     int j;
 } Location;
 
+// Packed tile configuration. The tile at position p = i*N+j occupies TILEBITS bits
+// starting at bit p*TILEBITS, two states are equal iff the words are.
+// 3x3: 4 bits per tile in 64 bits, the position of the blank tile is cached in the
+//      4 bits above the board so it never has to be searched for
+// 4x4: 4 bits per tile fill all 64 bits, the blank is the only cell holding 0
+// 5x5: 5 bits per tile in 128 bits
+#if N == 3
+typedef uint64_t State;
+#define TILEBITS 4
+#define BOARDMASK ((((State)1) << (NTILES*TILEBITS)) - 1)
+#define BLANKSHIFT (NTILES*TILEBITS)
+#define GetBlank(s) ((int)(((s) >> BLANKSHIFT) & TILEMASK))
+#elif N == 4
+typedef uint64_t State;
+#define TILEBITS 4
+#define BOARDMASK (~(State)0)
+#define GetBlank(s) FindZeroTile(s)
+#elif N == 5
+typedef unsigned __int128 State;
+#define TILEBITS 5
+#define BOARDMASK ((((State)1) << (NTILES*TILEBITS)) - 1)
+#define GetBlank(s) FindZeroTile(s)
+#else
+#error "only 3x3, 4x4 and 5x5 boards are supported"
+#endif
+#define TILEMASK ((((State)1) << TILEBITS) - 1)
+#define LOWBITS (BOARDMASK / TILEMASK)     // lowest bit of every cell
+#define GetTile(s,p) ((int)(((s) >> ((p)*TILEBITS)) & TILEMASK))
+
 struct Node             // node of the search space
 {
-    int **layout;       // tile configuration
+    State layout;       // tile configuration
     int g_val;          // cost to reach this node
     float h_val;
     float f_val;
@@ -33,6 +179,15 @@ struct Node             // node of the search space
     struct Node *parent;// pointer to the parent. We will use this for tracing back
 };
 
+// Moves of the blank from one cell: the move codes in increasing order and the cells the
+// blank moves to. Children are generated by walking such a list, see MoveTable.
+struct MoveList
+{
+    signed char count;                  // number of moves
+    signed char move[MAXVALIDMOVES];    // 0 left, 1 right, 2 top, 3 bottom
+    signed char to[MAXVALIDMOVES];      // cell of the blank after the move
+};
+
 // search queue elements
 struct SearchQueueElement
 {
@@ -40,88 +195,1002 @@ struct SearchQueueElement
     struct SearchQueueElement *next;    // pointer to the next element in the search queue
 };
 
+// Additive pattern database. The tiles are split into disjoint patterns, for every placement
+// of the tiles of a pattern the table holds the number of moves of pattern tiles needed to
+// bring them home. Moves of the other tiles are free, so the values of all patterns add up
+// to an admissible heuristic. A table entry is (distance - Manhattan distance of the pattern
+// tiles)/2, which is always a whole number and fits in 4 bits (larger values are capped,
+// which keeps the heuristic admissible). h = Manhattan distance + 2 * sum of the entries.
+struct PatternDatabase
+{
+    int ntiles;                 // number of tiles in the pattern
+    int tiles[NTILES];          // the tiles of the pattern
+    size_t entries;             // NTILES!/(NTILES-ntiles)! placements
+    const unsigned char *table; // entries nibbles, two per byte
+};
+
+struct PatternDatabases
+{
+    int count;                  // number of patterns, 0 if none are loaded
+    struct PatternDatabase pattern[NTILES];
+    int patternof[NTILES];      // pattern of every tile, -1 for the blank
+    void *map;                  // mapping of the pattern database file
+    size_t mapsize;
+};
+
+// header of a pattern database file, followed by the table of every pattern padded to 8 bytes
+struct PatternFileHeader
+{
+    char magic[8];
+    int32_t n;                  // board size
+    int32_t count;              // number of patterns
+    int32_t patternof[NTILES];  // pattern of every tile, -1 for the blank
+    int32_t goalpos[NTILES];    // goal position of every tile, the tables only hold for this goal
+};
+
+// Optimal distance to the goal of every configuration of the 8-puzzle, a nibble for each
+// at index OracleIndex
+struct DistanceOracle
+{
+    const unsigned char *table; // NULL if no oracle is loaded
+    void *map;                  // mapping of the oracle file
+    size_t mapsize;
+};
+
+// header of a distance oracle file, followed by the table
+struct OracleFileHeader
+{
+    char magic[8];
+    int32_t n;                  // board size
+    int32_t goalpos[NTILES];    // goal position of every tile, the table only holds for this goal
+};
+
+// cost of every tile on every position under each heuristic, built from the goal. A move
+// only changes the position of one tile and of the blank, so the heuristic value of a
+// child is the value of its parent plus the difference of four table entries.
+struct HeuristicTables
+{
+    unsigned char cost[NHEURISTICS][NTILES][NTILES];
+    const struct PatternDatabases *pdbs;   // pattern databases for HEURISTIC_PDB, NULL if none are loaded
+    State goal;
+    signed char goalrow[NTILES];        // goal row and column of every tile
+    signed char goalcol[NTILES];
+    int blankrow;                       // goal row and column of the blank
+    int blankcol;
+};
+
+// walking distance table for one goal line of the blank. Along the rows (columns) a state
+// is the line of the blank and how many tiles of every goal line each line holds, the
+// distance is the number of moves of tiles between neighbouring lines that bring all
+// tiles into their goal lines. The states are numbered in the order they were reached.
+struct WalkingDistance
+{
+    int count;
+    uint64_t *keys;             // state of every number, see WalkingKey
+    unsigned char *distance;    // distance of every number to the goal
+    int *slots;                 // hash table from the keys to the numbers, -1 for empty slots
+    int mask;                   // slots - 1
+};
+
+// counters and timers of a search that the search functions do not keep themselves.
+// Every thread has its own, threads of a parallel search add theirs up at the end
+struct SearchMetrics
+{
+    long long duplicates;       // children dropped by the closed table
+    long long improvements;     // children that lowered the cost of a configuration not yet expanded
+    long long reopenings;       // expanded configurations reached again with a lower cost
+    size_t peak_bytes;          // memory of other threads of the search
+    size_t start_bytes;         // memory the search structures of the thread held when the search started
+    int over_budget;            // the search gave up on its time or memory budget
+    int failed;                 // memory, a thread or a file of the search could not be had
+    struct P1Incumbent incumbents[P1_MAX_INCUMBENTS];   // solutions of arastar, see RecordIncumbent
+    int nincumbents;
+    uint64_t phase_start[NPHASES];
+    uint64_t phase_ns[NPHASES];
+};
+
+// settings of the searches of a thread. main sets those of its own thread, the threads
+// that a search or a batch starts take over the settings of the thread that started them
+struct SearchSettings
+{
+    int heuristic;              // heuristic of AStar and IDAStar
+    int threads;                // threads of HDA* and parallel IDA*
+    uint64_t timelimit;         // nanoseconds a search may take, 0 for no limit
+    size_t memorylimit;         // bytes the search structures of a thread may hold, 0 for no limit
+    int nodebudget;             // nodes SMA* may keep
+    double weight;              // inflation of the heuristic in the first round of ARA*
+    double weightstep;          // decrease of the inflation between rounds of ARA*
+    int cacheentries;           // entries of the transposition cache of iddfs
+    const char *spilldirectory;     // directory of the files of external memory BFS, $TMPDIR or /tmp if NULL
+};
+
+// state of the depth first sweeps of IDA*
+struct IDAStarSearch
+{
+    State goal;
+    State board;                // configuration at the end of the current path
+    int bound;                  // f bound of the current iteration
+    int nextbound;              // smallest f that exceeded the bound
+    int depth;                  // length of the solution once found
+    int max_depth;
+    long long nodes_expanded;
+    long long nodes_generated;
+    int moves[MAX_SOLUTION_LENGTH+1];   // moves of the current path, the first move first
+    atomic_int *found;          // parallel IDA*: lowest work unit with a solution, NULL for IDAStar
+    int unit;                   // parallel IDA*: work unit of this sweep
+    int stopped;                // the sweep was abandoned for a solution in a lower unit
+};
+
+// entry of the transposition cache of iterative deepening: no goal is within remaining
+// moves of layout when the blank does not move back against lastmove
+struct TranspositionEntry
+{
+    State layout;               // 0 for an empty entry
+    signed char lastmove;
+    unsigned char remaining;
+};
+
+// state of the depth first sweeps of iterative deepening
+struct IDDFSSearch
+{
+    State goal;
+    State board;                // configuration at the end of the current path
+    int limit;                  // depth limit of the current iteration
+    int depth;                  // length of the solution once found
+    int max_depth;
+    long long nodes_expanded;
+    long long nodes_generated;
+    int moves[MAX_SOLUTION_LENGTH+1];   // moves of the current path, the first move first
+    struct TranspositionEntry *cache;   // buckets of two entries
+    size_t mask;                // buckets - 1
+    int stopped;                // the budget is spent
+};
+
+// work unit of parallel IDA*: a node of the split frontier and the moves that lead to it
+struct PIDAUnit
+{
+    State board;
+    int g;
+    int h;
+    int lastmove;
+    unsigned char moves[PIDA_MAX_SPLIT_DEPTH];
+};
+
+// work units of one thread of parallel IDA*, the indices front to back-1. The owner takes
+// units from the front, idle threads steal from the back
+struct PIDADeque
+{
+    _Alignas(64) pthread_mutex_t lock;
+    int front;
+    int back;
+};
+
+// one thread of parallel IDA*
+struct PIDAWorker
+{
+    struct PIDAStarSearch *search;
+    int index;
+    pthread_t thread;
+};
+
+// state shared by the threads of one iteration of parallel IDA*
+struct PIDAStarSearch
+{
+    State goal;
+    const struct PatternDatabases *pdbs;
+    int nworkers;
+    int bound;
+    struct PIDAUnit *units;     // the split frontier in depth first order
+    int nunits;
+    int unitcapacity;
+    struct PIDAUnit *spare;     // the next level of the frontier while it is split
+    int sparecapacity;
+    struct PIDADeque *deques;
+    atomic_int nextbound;       // smallest f that exceeded the bound
+    atomic_int found;           // lowest unit with a solution, written under lock
+    pthread_mutex_t lock;
+    int depth;                  // length of the solution of unit found
+    int moves[MAX_SOLUTION_LENGTH+1];
+    long long nodes_expanded;
+    long long nodes_generated;
+    int max_depth;
+    struct SearchMetrics metrics;
+    uint64_t deadline;          // searchdeadline of the caller
+    struct SearchSettings settings;     // searchsettings of the caller
+};
+
+// a child sent by HDA* to the thread that owns its configuration
+struct HDAMessage
+{
+    _Atomic(struct HDAMessage *) next;
+    State layout;
+    int g_val;
+    float h_val;
+    int move;
+    struct Node *parent;
+};
+
+// lock free queue of messages with many senders and one receiver. Senders swap themselves
+// in at the tail, the receiver follows next pointers from the head. stub keeps the queue
+// from ever running empty so that senders never touch the head.
+struct HDAInbox
+{
+    _Alignas(64) _Atomic(struct HDAMessage *) tail;
+    _Alignas(64) struct HDAMessage *head;
+    struct HDAMessage stub;
+};
+
+// one thread of HDA*. It owns the configurations that hash to its index, their nodes
+// live in its open list, closed table and arena
+struct HDAWorker
+{
+    struct HDAInbox inbox;
+    struct HDAStarSearch *search;
+    int index;
+    pthread_t thread;
+    long long nodes_expanded;
+    long long nodes_generated;
+    int max_depth;
+    long long memory_consumed;
+    struct SearchMetrics metrics;
+};
+
+// state shared by the threads of HDA*
+struct HDAStarSearch
+{
+    State goal;
+    const struct PatternDatabases *pdbs;
+    int nworkers;
+    struct HDAWorker *workers;
+    atomic_int best;            // cost of the best solution found so far
+    struct Node *goalnode;      // goal node of that solution, written under lock
+    pthread_mutex_t lock;
+    atomic_long inflight;       // messages sent but not yet received
+    atomic_int idle;            // threads without nodes to expand
+    atomic_long epoch;          // incremented whenever an idle thread receives work
+    atomic_int done;
+    atomic_int go;              // 1 once every thread runs, -1 if one could not be started
+    uint64_t deadline;          // searchdeadline of the caller
+    struct SearchSettings settings;     // searchsettings of the caller
+    pthread_barrier_t barrier;
+    int *path;
+};
+
+// bump allocator that owns the nodes and search queue elements of one search.
+// Memory is handed out from large blocks and only given back all at once. A reset keeps
+// the blocks for the next search, which then fills them again from the first one.
+struct ArenaBlock
+{
+    struct ArenaBlock *next;    // block filled after this one
+    size_t size;                // bytes of the block, header included
+};
+
+struct Arena
+{
+    struct ArenaBlock *first;   // first block of the list
+    struct ArenaBlock *blocks;  // block currently allocated from
+    char *cur;                  // next free byte of the current block
+    char *end;                  // end of the current block
+    size_t bytesused;           // bytes handed out since the arena was last reset
+    size_t bytesreserved;       // bytes obtained from malloc
+};
+
+// frontier of breadth first search, a growable ring buffer of nodes
+struct NodeQueue
+{
+    struct Node **nodes;
+    size_t capacity;            // always a power of 2
+    size_t first;               // slot of the node at the front
+    size_t count;
+};
+
+// open list element. The priority and the heuristic value used to break ties are kept
+// next to the node pointer so that sifting never has to dereference the nodes
+struct OpenListElement
+{
+    float key;                  // f value for A*, h value for greedy best first search
+    float h_val;                // ties are broken on lower h, i.e. deeper nodes first
+    struct Node *nodeptr;
+};
+
+// open list of the best first searches, an array backed binary min-heap
+struct OpenList
+{
+    struct OpenListElement *elements;
+    int size;
+    int capacity;
+};
+
+// closed table entry. A layout of 0 marks an empty slot, no valid configuration packs to 0
+struct ClosedEntry
+{
+    State layout;
+    int g_val;                  // lowest cost with which the configuration has been reached
+    int expanded;               // the configuration has been expanded with cost g_val
+};
+
+// closed set shared by all searches, an open addressing hash table keyed on the configuration
+struct ClosedTable
+{
+    struct ClosedEntry *entries;
+    size_t capacity;            // number of slots, always a power of 2
+    size_t count;               // number of occupied slots
+    size_t maxbytes;            // the table does not grow beyond this many bytes
+};
+
+// statistics of the last search of a thread
+struct SearchStats
+{
+    long long nodes_expanded;
+    long long nodes_generated;
+    int max_depth;
+    long long memory_consumed;      // largest number of nodes waiting to be expanded
+    size_t arena_bytes;
+    long long duplicates;
+    long long improvements;
+    long long reopenings;
+    size_t peak_bytes;              // memory the search structures grew by, they never shrink during a search
+    uint64_t elapsed_ns;
+    uint64_t phase_ns[NPHASES];
+    int over_budget;
+    int failed;
+    struct P1Incumbent incumbents[P1_MAX_INCUMBENTS];
+    int nincumbents;
+};
+
+// one start state of a batch and the result of its search
+struct BatchInstance
+{
+    State start;
+    int line;           // line of the batch file
+    int valid;          // 0 if the line does not hold a tile configuration
+    int solvable;       // 0 if the goal can not be reached from the start state
+    int moves;          // length of the solution, -1 if there is none
+    int optimal;        // known length of an optimal solution, -1 if it is not known
+    struct SearchStats stats;
+    uint64_t elapsed_ns;    // wall clock time of the search including the setup of Solve
+    int done;
+};
+
+// work shared by the threads of a batch. instances are handed out in order through next,
+// results are printed in order by whichever thread completes the next one to print
+struct Batch
+{
+    struct BatchInstance *instances;
+    int count;
+    int algorithm;
+    State goal;
+    const struct PatternDatabases *pdbs;
+    struct SearchSettings settings;     // searchsettings of the thread that started the batch
+    atomic_int next;
+    pthread_mutex_t lock;
+    int printed;        // instances whose result line has been written
+};
+
+// node of SMA*. The nodes live in a pool of the node budget and are reused once dropped
+struct SMANode
+{
+    State layout;
+    int g_val;
+    int h_val;
+    int f_val;                  // f, raised to the lowest f of the dropped children when they are all gone
+    int forgotten;              // lowest f of the children dropped from memory, INT_MAX if none
+    int move;                   // move from the parent to reach this node
+    unsigned char children;     // moves whose child is in memory, one bit per move
+    unsigned char inuse;
+    unsigned int stamp;         // changes whenever the node leaves the heaps, older entries are stale
+    struct SMANode *parent;
+};
+
+// heap entry of SMA*, the key is copied so that stale entries can still be ordered
+struct SMAHeapEntry
+{
+    int key;
+    int g_val;
+    unsigned int stamp;
+    struct SMANode *node;
+};
+
+// binary heap of SMA*: the best node (lowest key, deepest) first, or with worst set the
+// leaf to drop (highest key, shallowest) first. Entries are not removed when a node
+// changes, they go stale and are skipped when they come to the top.
+struct SMAHeap
+{
+    struct SMAHeapEntry *entries;
+    int size;
+    int capacity;
+    int worst;
+};
+
+// state of one SMA* search
+struct SMAStarSearch
+{
+    struct SMANode *pool;       // budget nodes, the first next of them have been handed out
+    struct SMANode *free;       // dropped nodes, linked through parent
+    int budget;
+    int next;
+    int used;
+    struct SMAHeap open;        // nodes with children still to generate
+    struct SMAHeap leaves;      // nodes without children in memory
+    long long nodes_dropped;
+};
+
+// sequential reader of a file of sorted states
+struct StateStream
+{
+    FILE *fp;
+    State cur;                  // the state at the front of the stream
+    int valid;                  // 0 once the stream is used up
+};
+
+// external memory breadth first search. Layer d is a file of the configurations at
+// distance d, sorted and without duplicates. A layer is generated as sorted runs of the
+// size of the buffer, which are merged into the next layer file
+struct ExternalBFS
+{
+    char prefix[SPILL_NAME_LENGTH-32];     // path of the files without the layer or run number
+    State *run;                 // buffer of the successors not yet written
+    size_t runcapacity;
+    size_t runsize;
+    int nruns;                  // runs written for the layer being generated
+    long long bytes_written;
+    long long nodes_expanded;
+    long long nodes_generated;
+};
+
+// results of one algorithm and heuristic over all instances of a benchmark
+struct BenchResult
+{
+    char algorithm[16];
+    char heuristic[16];
+    int instances;
+    int solved;
+    int over_budget;
+    double median_seconds;      // over the solved instances
+    double p95_seconds;
+    long long median_expanded;
+    long long p95_expanded;
+};
+
+// the search variables of a thread, see SwapSearchContext
+struct SearchContext
+{
+    struct SearchQueueElement *head;
+    struct Arena arena;
+    struct HeuristicTables htables;
+    struct NodeQueue frontier;
+    struct OpenList openlist;
+    struct ClosedTable closed;
+    struct NodeQueue backfrontier;
+    struct OpenList backopenlist;
+    struct ClosedTable backclosed;
+    struct HeuristicTables backtables;
+    struct NodeQueue incons;
+    struct ClosedTable roundclosed;
+    struct SearchStats searchstats;
+    struct SearchMetrics metrics;
+    uint64_t searchdeadline;
+    int searchverbose;
+    struct SearchSettings searchsettings;
+};
+
+// request of the server, a line read from a connection
+struct ServerRequest
+{
+    struct ServerConnection *connection;
+    long long id;               // number of the line on its connection unless it gives -id
+    uint64_t arrival;           // monotonic time the line was read
+    char line[BATCH_LINE_LENGTH];
+    struct ServerRequest *next;
+};
+
+// client of the server. The requests read from it keep it until the last reply is written
+struct ServerConnection
+{
+    int infd;
+    int outfd;                  // the same socket as infd, or the standard output
+    char buffer[BATCH_LINE_LENGTH+1];   // start of a line not complete yet
+    int length;
+    long long lines;            // lines read, the numbers of the requests as in batch mode
+    int overlong;               // the line being read is longer than the buffer and is dropped up to its end,
+                                // 1 if it gets a reply, 2 for a comment
+    int pending;                // requests queued or being solved, under the lock of the server
+    int closed;                 // no more lines come, under the lock of the server
+    pthread_mutex_t writelock;  // replies go out one at a time
+};
+
+// state of the server shared by the reading thread and the worker threads
+struct Server
+{
+    const char *pdbfile;        // pattern databases every solver maps, NULL for none
+    int algorithm;              // default algorithm of requests
+    struct SearchSettings settings;     // default settings of requests
+    pthread_mutex_t lock;
+    pthread_cond_t ready;       // a request is queued or the server stops
+    struct ServerRequest *first;        // queue of the requests not taken by a worker
+    struct ServerRequest *last;
+    int stopping;
+    long long answered;
+    long long solved;
+    double latencies[SERVER_LATENCY_SAMPLES];   // seconds from arrival to reply of the latest requests
+};
+
+// solver of the library interface, see p1.h
+struct P1Solver
+{
+    struct SearchContext context;   // search variables, those of the thread while it solves with this solver
+    struct PatternDatabases pdbs;   // count is 0 if none are loaded
+    State defaultgoal;          // goal of SetGoal, the only one the pattern databases hold for
+    int *moves;                 // moves of the last result
+    int capacity;
+};
+
 void SetGoal(int **a);       // Set the goal state of the puzzle
-void PrintPuzzle(int **a);      // print the puzzle to the standard output
-void MoveTile(int **a, Location x, int direction);     // move tile at location x along the direction
-void Scramble(int **a);      // scramble the initial pattern moves number of times
-void FindBlankTile(int **a, Location *blank);       // find the location of the blank tile
+State DefaultGoal();        // the goal state of SetGoal
+State PackLayout(int **a);      // pack a tile configuration into a state
+void UnpackLayout(State s, int **a);    // expand a state into a tile configuration
+void PrintPuzzle(State a);      // print the puzzle to the standard output
+State MoveTile(State a, int direction);     // move the blank tile along the direction
+State MoveBlank(State a, int from, int to);     // move the blank tile between two adjacent cells
+State Scramble(State a);      // scramble the initial pattern moves number of times
+void FindBlankTile(State a, Location *blank);       // find the location of the blank tile
+int FindZeroTile(State a);      // position of the cell holding 0
+int CountTileBits(State a);     // number of bits set in a state
 int IsValidMove(Location blank, int move);      // determine if a move is valid
-int HeuristicMisplacedTiles(int **goal, int **a);   // compute the heuristic - number of misplaced tiles
-int GoalTest(int **goal, int **a);      // Test if the current state is a goal state
-void PrintPath(int **a, int *path);     // print the path to the goal state
-int * BFS(int **goal, int **a);      // breadth first search
-int * DFS(int **goal, int **a);      // depth first search
-int * GBEFS(int **goal, int **a);      // greedy best first search
-int * AStar(int **goal, int **a);      // A star search
-int * IDAStar(int **goal, int **a);      // IDA star search
+int HeuristicMisplacedTiles(State goal, State a);   // compute the heuristic - number of misplaced tiles
+int HeuristicManhattanDistance(State goal, State a);    // compute the heuristic - sum of Manhattan distances
+void BuildHeuristicTables(struct HeuristicTables *t, State goal);   // precompute the tile costs for a goal
+int UpdateHeuristic(const struct HeuristicTables *t, int heuristic, State parent, State child, float h);  // heuristic value of a child
+int GoalTest(State goal, State a);      // Test if the current state is a goal state
+int ComputeHeuristic(const struct HeuristicTables *t, int heuristic, State goal, State a);  // heuristic value from scratch
+int LineCode(const struct HeuristicTables *t, State a, int line, int column);     // tiles of a row or column that belong to it
+void BuildLineConflicts();      // linear conflicts of every line code
+void BuildLineTables();         // tables of linear conflict and walking distance, once for all threads
+int HeuristicLinearConflict(const struct HeuristicTables *t, State a);    // Manhattan distance plus linear conflicts
+int HeuristicMaximum(const struct HeuristicTables *t, State a);     // maximum of the heuristics available
+#if N <= 4
+uint64_t WalkingKey(int blankline, int counts[N][N], int target);     // key of a walking distance state
+int WalkingSlot(const struct WalkingDistance *wd, uint64_t key);     // hash table slot of a key
+void AddWalkingState(struct WalkingDistance *wd, uint64_t key, int distance);    // number a new walking distance state
+void BuildWalkingDistance(struct WalkingDistance *wd, int target);     // walking distances for a goal line of the blank
+void BuildWalkingDistances();       // walking distances for every goal line of the blank
+int WalkingDistance(const struct HeuristicTables *t, State a, int column);    // walking distance along rows or columns
+#endif
+// pattern databases
+size_t RankPlacement(const int *pos, int k);    // index of a placement of k tiles
+void UnrankPlacement(size_t idx, int k, int *pos);      // placement of k tiles with the given index
+int HeuristicPatternDatabase(const struct PatternDatabases *pdbs, State goal, State a);     // additive pattern database heuristic
+int UpdatePatternHeuristic(const struct HeuristicTables *t, State parent, State child, int h);     // pattern database heuristic of a child
+int BuildPatternDatabases(const char *filename, State goal);    // build the tables of the default patterns and write them to a file
+int LoadPatternDatabases(struct PatternDatabases *pdbs, const char *filename, State goal);  // map a pattern database file
+void FreePatternDatabases(struct PatternDatabases *pdbs);     // unmap the pattern database file
+size_t OracleIndex(State a);        // slot of a configuration in the distance oracle
+int OracleDistance(const struct DistanceOracle *o, State a);    // distance to the goal modulo 16
+int BuildDistanceOracle(const char *filename, State goal);      // write the distances of all 8-puzzle configurations
+int LoadDistanceOracle(struct DistanceOracle *o, const char *filename, State goal);     // map a distance oracle file
+void FreeDistanceOracle(struct DistanceOracle *o);      // unmap the distance oracle file
+void PrintPath(State a, int *path);     // print the path to the goal state
+int ParseLayout(const char *text, State *a);    // read a tile configuration, tiles in row major order
+State PackTiles(const int *tiles);      // pack the tiles of the cells in row major order
+int PermutationParity(State a);     // parity that no move can change
+int IsSolvable(State goal, State a);    // determine if the goal can be reached
+int * Solve(int algorithm, State goal, State a);    // check the start state and run a search
+void SwapSearchContext(struct SearchContext *c);    // exchange the search variables of the thread with a context
+void ReportSearch(long long expanded, long long generated, int max_depth, long long memory, uint64_t elapsed_ns);    // record the statistics of a search
+// metrics
+uint64_t NowNanoseconds();      // monotonic clock in nanoseconds
+void ResetMetrics();        // start the metrics of the thread from zero
+void AddMetrics(struct SearchMetrics *to, const struct SearchMetrics *from);    // add up the metrics of two threads
+size_t SearchMemoryBytes();     // memory held by the search structures of the thread
+int OverBudget(long long nodes);    // check the time and memory budget of the search
+void FailSearch(const char *reason);    // give up a search that can not get memory or threads
+void PrintStatsHeader();        // column names of the CSV format
+void PrintStatsRecord(int instance, const char *algorithm, int moves, const struct SearchStats *s);    // print statistics in the chosen format
+int * BFS(State goal, State a);      // breadth first search
+int * DFS(State goal, State a);      // depth first search
+int * GBEFS(State goal, State a);      // greedy best first search
+int * AStar(State goal, State a);      // A star search
+int * IDAStar(State goal, State a);      // IDA star search
+int IDAStarSweep(struct IDAStarSearch *ida, int g, int h, int lastmove);     // one bounded depth first sweep of IDA*
+int * IDDFS(State goal, State a);       // iterative deepening depth first search
+int IDDFSSweep(struct IDDFSSearch *x, int g, int lastmove);     // one depth limited sweep of iterative deepening
+int ProbeTranspositions(const struct IDDFSSearch *x, State s, int lastmove, int remaining);  // look up a failed configuration
+void StoreTransposition(struct IDDFSSearch *x, State s, int lastmove, int remaining);    // record a failed configuration
+int * HDAStar(State goal, State a);     // hash distributed parallel A star search
+void *HDAStarWorker(void *arg);     // one thread of HDA*
+void PushHDAInbox(struct HDAInbox *q, struct HDAMessage *m);     // send a message to a thread
+struct HDAMessage *PopHDAInbox(struct HDAInbox *q);      // receive the oldest message of a thread
+int HDAOwner(const struct HDAStarSearch *hda, State s);     // thread that owns a configuration
+void SendHDAMessage(struct HDAStarSearch *hda, State layout, int g, float h, int move, struct Node *parent);   // hand a child to its owner
+void OpenHDANode(struct HDAWorker *self, State layout, int g, float h, int move, struct Node *parent);    // add an owned child to the open list
+int * PIDAStar(State goal, State a);    // parallel IDA star search
+int * OracleSearch(State goal, State a);    // optimal path read off the distance oracle
+int * BidirectionalBFS(State goal, State a);    // breadth first search from both ends
+int * MMSearch(State goal, State a);    // bidirectional A star that meets in the middle
+int DescendClosedTable(struct ClosedTable *t, State s, int *moves);     // walk a closed table down to its root
+int * JoinPaths(struct Node *node, int backward, struct ClosedTable *other);     // path through the meeting of two searches
+int * SMAStar(State goal, State a);     // A star within a fixed budget of nodes
+int SMAHeapBefore(const struct SMAHeap *heap, const struct SMAHeapEntry *a, const struct SMAHeapEntry *b);   // order of SMA* heap entries
+void PushSMAHeap(struct SMAHeap *heap, struct SMANode *node, int key);     // add a node to an SMA* heap
+struct SMAHeapEntry PopSMAHeap(struct SMAHeap *heap);       // remove the first entry of an SMA* heap
+void QueueSMANode(struct SMAStarSearch *s, struct SMANode *node);      // put a changed node into its heaps
+void CompactSMAHeaps(struct SMAStarSearch *s);      // clear the stale entries out of the heaps
+int DropSMALeaf(struct SMAStarSearch *s, struct SMANode *keep);       // free the worst leaf
+struct SMANode *NewSMANode(struct SMAStarSearch *s, struct SMANode *keep);     // take a node from the pool
+int * ExternalBFS(State goal, State a);     // breadth first search with the layers on disk
+int ExploreLayers(State start, int maxdepth);      // sizes of the layers around a configuration
+int StartExternalBFS(struct ExternalBFS *x);       // set up the buffer and file names of a search
+void EndExternalBFS(struct ExternalBFS *x, int first, int last);     // remove the files of a search
+void SpillFileName(const struct ExternalBFS *x, const char *kind, int number, char *name);    // file of a layer or run
+int CompareStates(const void *x, const void *y);    // order of states for qsort
+void SpillError(const char *name);      // a file of external memory BFS can not be used
+int OpenStateStream(struct StateStream *s, const char *name);      // start reading a file of states
+void NextState(struct StateStream *s);      // read the next state of a file
+void CloseStateStream(struct StateStream *s);
+int WriteFirstLayer(struct ExternalBFS *x, State start);     // layer file of the start state
+int WriteRun(struct ExternalBFS *x);        // spill the buffer as a sorted run
+long long MergeRuns(struct ExternalBFS *x, int layer, State goal, int *found);    // merge the runs into a layer file
+long long ExpandLayer(struct ExternalBFS *x, int layer, State goal, int *found);   // generate the next layer file
+int TraceLayers(struct ExternalBFS *x, int depth, State s, int *path);      // path back through the layer files
+int * ARAStar(State goal, State a);     // anytime A star with a decreasing weight
+int *TracePath(struct Node *curnode);       // path from the root to a node
+void RecordIncumbent(int length, double bound, long long expanded, uint64_t elapsed_ns);   // a solution of an anytime search
+void *PIDAStarWorker(void *arg);    // one thread of parallel IDA*
+int SplitPIDAStar(struct PIDAStarSearch *p);    // cut the tree one level deeper into work units
+int TakePIDAUnit(struct PIDAStarSearch *p, int index);      // next work unit of a thread
 // search traversal functions
-struct Node * CreateNode(int **a);         // create a node with the reuired information
+struct Node * CreateNode(State a);         // create a node with the reuired information
 struct SearchQueueElement *CreateSearchQueueElement(struct Node *curnode);        // Create hte search queue element
-void AppendSearchQueueElementToEnd(struct SearchQueueElement* cursqelement);   // append a search queue elment to the end of the queue
 void AppendSearchQueueElementToFront(struct SearchQueueElement* cursqelement);   // append a search queue elment to the Front of the queue
-void InsertSearchQueueElementPriorityh(struct SearchQueueElement* cursqelement);   // append a search queue elment According to hueristic value
-void InsertSearchQueueElementPriorityf(struct SearchQueueElement* cursqelement);   // append a search queue elment According to hueristic value
 void FreeSearchMemory();
+void ResetSearchMemory();    // empty the search structures of the thread, keeps their memory
+// batch mode
+int ReadBatch(struct Batch *b, const char *filename);     // read the start states of a batch file
+void *BatchWorker(void *arg);       // solve instances of a batch until none are left
+void FlushBatchResults(struct Batch *b);     // print the completed results that are next in order
+int SolveBatch(const char *filename, int algorithm, State goal, int nthreads, int korf);    // solve every start state of a file
+// benchmark
+uint64_t NextRandom(uint64_t *state);       // pseudo random numbers that are the same on every machine
+int GenerateDepthSet(struct Batch *b, State goal, int perdepth, uint64_t seed);     // 8- or 15-puzzle instances of every solution length
+void ConvertKorfInstances(struct Batch *b);     // renumber instances for the goal with the blank first
+int RunBenchmark(struct Batch *b, State goal, int algorithm, int heuristic, const char *baseline);   // time every algorithm and heuristic
+void BenchmarkCombination(struct Batch *b, State goal, int algorithm, int heuristic, struct BenchResult *r);   // one row of the benchmark
+void PrintBenchResult(const struct BenchResult *r);     // print a row of the benchmark table
+int PercentileIndex(int n, int percent);    // index of a percentile in sorted values
+int CompareDoubles(const void *x, const void *y);     // order of doubles for qsort
+int CompareLongLongs(const void *x, const void *y);   // order of long longs for qsort
+int CompareBaseline(const char *filename, const struct BenchResult *results, int count);  // report regressions against a baseline
+int PinBaselineSettings(const char *filename);    // run with the threads and time limit of a baseline
+// server mode
+int Serve(const char *socketname, int algorithm, int nthreads, const char *pdbfile);   // answer requests until stopped
+void *ServerWorker(void *arg);      // one solver of the server
+int AnswerRequest(struct Server *s, struct P1Solver *solver, struct ServerRequest *r);    // solve a request and reply
+int ReadRequests(struct Server *s, struct ServerConnection *c);     // queue the complete lines of a client
+struct ServerConnection *OpenConnection(struct ServerConnection **connections, int *count, int infd, int outfd);    // add a client
+void ReleaseConnection(struct ServerConnection *c);     // close a client that is done
+void WriteReply(struct ServerConnection *c, const char *text);     // send a reply line to a client
+int WriteAll(int fd, const char *text, size_t length);     // write a whole buffer
+void ServerStatistics(struct Server *s, char *text, size_t size);   // request counters and latency percentiles
+void StopServer(int signal);        // signal handler that ends the server
+// memory of the search nodes
+void *ArenaAlloc(struct Arena *a, size_t size);  // allocate size bytes from the arena
+void ArenaReset(struct Arena *a);    // free every allocation, keeps the blocks
+void FreeArena(struct Arena *a);     // release all memory of the arena
+// closed set of all searches
+uint64_t HashState(State s);    // hash a configuration
+int UpdateClosedTable(struct ClosedTable *t, State s, int g);    // record a configuration, returns 0 for duplicates
+int LookupClosedTable(struct ClosedTable *t, State s);   // lowest recorded cost of a configuration
+int ExpandClosedEntry(struct ClosedTable *t, State s, int g);    // lookup that marks a configuration expanded
+void ClearClosedTable(struct ClosedTable *t);    // forget all configurations, keeps the memory
+void FreeClosedTable(struct ClosedTable *t);     // release the memory of the table
+// frontier of breadth first search
+int ReserveNodeQueue(struct NodeQueue *q, size_t n);    // make room for n more nodes
+void PushNodeQueue(struct NodeQueue *q, struct Node *curnode);   // append a node at the back
+struct Node *PopNodeQueue(struct NodeQueue *q);      // remove the node at the front
+// open list of the best first searches
+void PushOpenList(struct OpenList *open, struct Node *curnode, float key);     // insert a node with the given priority
+struct Node *PopOpenList(struct OpenList *open);     // remove the node with the lowest priority
 
 
-// search variables
-struct SearchQueueElement *head = NULL;
-int **goal;
+// search variables, every thread has its own so that searches can run concurrently
+_Thread_local struct SearchQueueElement *head = NULL;
+_Thread_local struct Arena arena = {NULL, NULL, NULL, NULL, 0, 0};
+_Thread_local struct HeuristicTables htables;
+_Thread_local struct NodeQueue frontier = {NULL, 0, 0, 0};
+_Thread_local struct OpenList openlist = {NULL, 0, 0};
+_Thread_local struct ClosedTable closed = {NULL, 0, 0, CLOSED_MAX_BYTES};
+// the backward search of the bidirectional searches, from the goal to the start
+_Thread_local struct NodeQueue backfrontier = {NULL, 0, 0, 0};
+_Thread_local struct OpenList backopenlist = {NULL, 0, 0};
+_Thread_local struct ClosedTable backclosed = {NULL, 0, 0, CLOSED_MAX_BYTES};
+_Thread_local struct HeuristicTables backtables;
+// the rounds of ARA*: nodes whose cost improved after they were expanded in the current
+// round, and the configurations expanded in it
+_Thread_local struct NodeQueue incons = {NULL, 0, 0, 0};
+_Thread_local struct ClosedTable roundclosed = {NULL, 0, 0, CLOSED_MAX_BYTES};
+_Thread_local struct SearchStats searchstats;
+_Thread_local struct SearchMetrics metrics;
+_Thread_local uint64_t searchdeadline = 0;  // monotonic time at which the search gives up, 0 for never
+_Thread_local int searchverbose = 1;   // print the progress and statistics of searches
+_Thread_local struct SearchSettings searchsettings = DEFAULT_SEARCH_SETTINGS;
+// settings shared by all threads, fixed before any search starts
+struct PatternDatabases patterndb;
+struct DistanceOracle distanceoracle;
+const char *AlgorithmNames[NALGORITHMS] = {"bfs", "dfs", "gbefs", "astar", "idastar", "hdastar", "pidastar", "oracle", "bibfs", "mm", "smastar", "extbfs", "arastar", "iddfs"};
+int statsformat = STATS_TEXT;
+const char *HeuristicNames[NSEARCHHEURISTICS] = {"misplaced", "manhattan", "pdb", "linear", "walking", "max"};
+unsigned char lineconflicts[LINECODES];     // extra moves of the linear conflicts of a line code
+#if N <= 4
+struct WalkingDistance walkingdistance[N];  // walking distances for every goal line of the blank
+#endif
+pthread_once_t linetablesonce = PTHREAD_ONCE_INIT;
+volatile sig_atomic_t serverstop = 0;     // set by SIGINT and SIGTERM in server mode
+const char *PhaseNames[NPHASES] = {"expand", "heuristic", "queue", "goaltest"};
+State goal;
 
+#ifndef P1_LIBRARY
 int main(int argc, char *argv[])
 {
-    int i, j;
-    int **puzzle;       // puzzle variable
+    int arg;
+    State puzzle;       // puzzle variable
     int *path;
+    int algorithm = ALGORITHM_ASTAR;
+    int scramble = 1;   // scramble the goal unless a start state is given
+    const char *batchfile = NULL;
+    const char *baseline = NULL;
+    const char *pdbfile = NULL;
+    const char *socketname = NULL;
+    int benchmark = 0, korf = 0, perdepth = BENCH_PER_DEPTH, chosen = -1, heuristic = -1, explore = -1;
+    uint64_t seed = BENCH_SEED;
+    struct Batch bench;
+    int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
 
-    // allocate memory to the variable that stores the puzzle.
-    puzzle = (int **)malloc(sizeof(int *)*N);
-    goal = (int **)malloc(sizeof(int *)*N);
-    for (i=0; i<N; i++)
+    // set the goal state the puzzle
+    goal = DefaultGoal();
+
+    // command line options
+    // -a algorithm     bfs, dfs, gbefs, astar (default), idastar, hdastar, pidastar, oracle,
+    //                  bibfs (bidirectional breadth first), mm (bidirectional A*) or
+    //                  smastar (A* within a node budget), extbfs (breadth first with the layers on disk)
+    //                  arastar (anytime A*, improves a first solution until it is shortest) or
+    //                  iddfs (iterative deepening depth first with a transposition cache)
+    // -start "tiles"   start state, the tiles in row major order with 0 for the blank
+    // -batch file      solve every start state of file, one per line, and print a result line for each
+    // -threads n       number of threads of batch mode, hdastar and pidastar, all cores by default
+    // -buildpdb file   build the pattern databases for the goal, write them to file and exit
+    // -pdb file        use the pattern databases in file as the heuristic of AStar and IDAStar
+    // -buildoracle file  write the distances of all 8-puzzle configurations to file and exit
+    // -oracle file     answer 8-puzzle queries from the distance oracle in file
+    // -stats format    print the statistics of searches as text (default), json or csv
+    // -heuristic name  heuristic of AStar and IDAStar: misplaced, manhattan (default), pdb,
+    //                  linear (Manhattan plus linear conflicts), walking (walking distance,
+    //                  up to 4x4) or max (the largest of linear, walking and pdb)
+    // -timelimit s     seconds a search may take before it gives up
+    // -memlimit mb     megabytes the search structures of a thread may hold before it gives up
+    // -nodes n         nodes SMA* may keep in memory
+    // -weight e        inflation of the heuristic in the first round of arastar, 3 by default
+    // -weightstep d    decrease of the inflation between rounds of arastar, 0.5 by default
+    // -cache n         entries of the transposition cache of iddfs
+    // -spill dir       directory of the layer files of extbfs, $TMPDIR or /tmp by default;
+    //                  -memlimit sets the size of its sorted runs
+    // -explore d       print the sizes of the first d layers around the start state, or around
+    //                  the goal without -start, using the layer files of extbfs
+    // -bench           run every algorithm and heuristic over the 8- or 15-puzzle instances of
+    //                  every solution length, or over the instances of -batch file, and print a table;
+    //                  -a and -heuristic restrict it to one algorithm and heuristic
+    // -perdepth k      benchmark instances per solution length
+    // -seed n          seed of the generated benchmark instances
+    // -korf            the instances of -batch file are for the goal with the blank first,
+    //                  as in Korf's 100 15-puzzle instances, the first 23 of which are in bench/korf.txt
+    // -baseline file   compare the benchmark with the table in file, exit status 2 on regressions;
+    //                  the benchmark runs with the threads and time limit the table records
+    // -serve socket    answer requests on the Unix socket until SIGINT or SIGTERM, or on the
+    //                  standard input and output if socket is -, with -threads solvers that
+    //                  stay warm between requests. A request is a line of tiles, optionally
+    //                  after -id n, -a algorithm, -heuristic name and -timelimit s, and gets
+    //                  a line "id moves expanded seconds path" back; the line "stats" gets
+    //                  the numbers of requests and the p50 and p99 latencies in seconds
+    for (arg=1; arg<argc; arg++)
+    {
+        if (strcmp(argv[arg], "-a") == 0 && arg+1 < argc)
+        {
+            arg++;
+            for (algorithm=0; algorithm<NALGORITHMS; algorithm++)
+                if (strcmp(argv[arg], AlgorithmNames[algorithm]) == 0)
+                    break;
+            if (algorithm == NALGORITHMS)
+            {
+                fprintf(stderr, "unknown algorithm %s\n", argv[arg]);
+                return(1);
+            }
+            chosen = algorithm;
+        }
+        else if (strcmp(argv[arg], "-heuristic") == 0 && arg+1 < argc)
+        {
+            arg++;
+            for (searchsettings.heuristic=0; searchsettings.heuristic<NSEARCHHEURISTICS; searchsettings.heuristic++)
+                if (strcmp(argv[arg], HeuristicNames[searchsettings.heuristic]) == 0)
+                    break;
+            if (searchsettings.heuristic == NSEARCHHEURISTICS || (searchsettings.heuristic == HEURISTIC_PDB && htables.pdbs == NULL) ||
+                    (searchsettings.heuristic == HEURISTIC_WALKING && N > 4))
+            {
+                fprintf(stderr, "unknown heuristic %s, pdb needs -pdb file first, walking a board of at most 4x4\n", argv[arg]);
+                return(1);
+            }
+            heuristic = searchsettings.heuristic;
+        }
+        else if (strcmp(argv[arg], "-timelimit") == 0 && arg+1 < argc)
+            searchsettings.timelimit = (uint64_t)(atof(argv[++arg])*1e9);
+        else if (strcmp(argv[arg], "-memlimit") == 0 && arg+1 < argc)
+            searchsettings.memorylimit = (size_t)(atof(argv[++arg])*(1<<20));
+        else if (strcmp(argv[arg], "-nodes") == 0 && arg+1 < argc)
+            searchsettings.nodebudget = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-weight") == 0 && arg+1 < argc)
+            searchsettings.weight = atof(argv[++arg]);
+        else if (strcmp(argv[arg], "-weightstep") == 0 && arg+1 < argc)
+            searchsettings.weightstep = atof(argv[++arg]);
+        else if (strcmp(argv[arg], "-cache") == 0 && arg+1 < argc)
+            searchsettings.cacheentries = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-spill") == 0 && arg+1 < argc)
+            searchsettings.spilldirectory = argv[++arg];
+        else if (strcmp(argv[arg], "-explore") == 0 && arg+1 < argc)
+            explore = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-bench") == 0)
+            benchmark = 1;
+        else if (strcmp(argv[arg], "-perdepth") == 0 && arg+1 < argc)
+            perdepth = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-seed") == 0 && arg+1 < argc)
+            seed = strtoull(argv[++arg], NULL, 10);
+        else if (strcmp(argv[arg], "-korf") == 0)
+            korf = 1;
+        else if (strcmp(argv[arg], "-baseline") == 0 && arg+1 < argc)
+            baseline = argv[++arg];
+        else if (strcmp(argv[arg], "-start") == 0 && arg+1 < argc)
+        {
+            if (ParseLayout(argv[++arg], &puzzle) == 0)
+            {
+                fprintf(stderr, "a start state needs %d tiles between 0 and %d\n", NTILES, NTILES-1);
+                return(1);
+            }
+            scramble = 0;
+        }
+        else if (strcmp(argv[arg], "-batch") == 0 && arg+1 < argc)
+            batchfile = argv[++arg];
+        else if (strcmp(argv[arg], "-serve") == 0 && arg+1 < argc)
+            socketname = argv[++arg];
+        else if (strcmp(argv[arg], "-threads") == 0 && arg+1 < argc)
+            nthreads = atoi(argv[++arg]);
+        else if (strcmp(argv[arg], "-stats") == 0 && arg+1 < argc)
+        {
+            arg++;
+            if (strcmp(argv[arg], "json") == 0)
+                statsformat = STATS_JSON;
+            else if (strcmp(argv[arg], "csv") == 0)
+                statsformat = STATS_CSV;
+            else if (strcmp(argv[arg], "text") == 0)
+                statsformat = STATS_TEXT;
+            else
+            {
+                fprintf(stderr, "unknown statistics format %s\n", argv[arg]);
+                return(1);
+            }
+        }
+        else if (strcmp(argv[arg], "-buildpdb") == 0 && arg+1 < argc)
+            return(BuildPatternDatabases(argv[++arg], goal) ? 0 : 1);
+        else if (strcmp(argv[arg], "-pdb") == 0 && arg+1 < argc)
+        {
+            pdbfile = argv[++arg];
+            if (LoadPatternDatabases(&patterndb, pdbfile, goal) == 0)
+                return(1);
+            htables.pdbs = &patterndb;
+            searchsettings.heuristic = HEURISTIC_PDB;
+        }
+        else if (strcmp(argv[arg], "-buildoracle") == 0 && arg+1 < argc)
+            return(BuildDistanceOracle(argv[++arg], goal) ? 0 : 1);
+        else if (strcmp(argv[arg], "-oracle") == 0 && arg+1 < argc)
+        {
+            if (LoadDistanceOracle(&distanceoracle, argv[++arg], goal) == 0)
+                return(1);
+            if (chosen < 0)
+                algorithm = ALGORITHM_ORACLE;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-a algorithm] [-start \"tiles\"] [-batch file] [-threads n] [-buildpdb file] [-pdb file] [-stats format] [-heuristic name]\n"
+                            "       [-buildoracle file] [-oracle file] [-timelimit s] [-memlimit mb] [-nodes n] [-spill dir] [-explore d]\n"
+                            "       [-weight e] [-weightstep d] [-cache n]\n"
+                            "       [-bench] [-perdepth k] [-seed n] [-korf] [-baseline file] [-serve socket]\n", argv[0]);
+            return(1);
+        }
+    }
+
+    if (algorithm == ALGORITHM_ORACLE && distanceoracle.table == NULL)
     {
-        puzzle[i] = (int *)calloc(N, sizeof(int));
-        goal[i] = (int *)calloc(N, sizeof(int));
+        fprintf(stderr, "the oracle needs -oracle file, built with -buildoracle file\n");
+        return(1);
     }
 
-    // set the goal state the puzzle
-    SetGoal(puzzle);
+    if (benchmark)
+    {
+        // searches are timed one at a time, the parallel ones with the threads of -threads
+        searchsettings.threads = nthreads;
+        if (searchsettings.timelimit == 0)
+            searchsettings.timelimit = (uint64_t)BENCH_TIME_LIMIT*1000000000ULL;
+        if (batchfile != NULL)
+            arg = ReadBatch(&bench, batchfile);
+        else
+            arg = GenerateDepthSet(&bench, goal, perdepth, seed);
+        if (arg == 0)
+            return(1);
+        if (korf)
+            ConvertKorfInstances(&bench);
+        arg = RunBenchmark(&bench, goal, chosen, heuristic, baseline);
+        free(bench.instances);
+        FreeSearchMemory();
+        FreePatternDatabases(&patterndb);
+        FreeDistanceOracle(&distanceoracle);
+        return(arg);
+    }
 
-    for (i=0; i<N; i++)
-        for (j=0; j<N; j++)
-            goal[i][j] = puzzle[i][j];
+    if (socketname != NULL)
+    {
+        arg = Serve(socketname, algorithm, nthreads, pdbfile);
+        FreePatternDatabases(&patterndb);
+        FreeDistanceOracle(&distanceoracle);
+        return(arg);
+    }
+
+    if (batchfile != NULL)
+    {
+        // the threads solve instances side by side, every search itself runs on one thread
+        arg = SolveBatch(batchfile, algorithm, goal, nthreads, korf);
+        FreePatternDatabases(&patterndb);
+        FreeDistanceOracle(&distanceoracle);
+        return(arg);
+    }
 
-    printf("Goal state tile configuration:\n");
-    // print the goal tile configuration
-    PrintPuzzle(goal);
+    if (explore >= 0)
+    {
+        arg = ExploreLayers(scramble ? goal : puzzle, explore);
+        FreePatternDatabases(&patterndb);
+        FreeDistanceOracle(&distanceoracle);
+        return(arg);
+    }
 
-    Scramble(puzzle);
+    searchsettings.threads = nthreads;
+    if (scramble)
+        puzzle = Scramble(goal);
 
-    printf("Start state tile configuration:\n");
-    // print the start state tile configuration
-    PrintPuzzle(puzzle);
+    // machine readable statistics come without anything else on stdout
+    if (statsformat == STATS_TEXT)
+    {
+        printf("Goal state tile configuration:\n");
+        // print the goal tile configuration
+        PrintPuzzle(goal);
+        printf("Start state tile configuration:\n");
+        // print the start state tile configuration
+        PrintPuzzle(puzzle);
+    }
+    else
+        searchverbose = 0;
 
-    // perform breadth first search
-    //path = BFS(goal, puzzle);
-    //path = DFS(goal, puzzle);
-    //path = GBEFS(goal, puzzle);
-    path = AStar(goal, puzzle);
-    //path = IDAStar(goal, puzzle);
+    // perform the search
+    memset(&searchstats, 0, sizeof(searchstats));
+    path = Solve(algorithm, goal, puzzle);
+    PrintStatsHeader();
+    PrintStatsRecord(1, AlgorithmNames[algorithm], path != NULL ? path[0] : -1, &searchstats);
     //print path
 //    PrintPath(puzzle, path);
 
     // free memory
     FreeSearchMemory();
-    for (i=0; i<N; i++)
-    {
-        free(puzzle[i]);
-        free(goal[i]);
-    }
-    free(puzzle);
-    free(goal);
+    FreePatternDatabases(&patterndb);
+    FreeDistanceOracle(&distanceoracle);
     free(path);
 
     return(1);
 }
+#endif
 
 // This function sets the goal configuration of the tiles in the puzzle. Feel free to replace
 // the code within the function to any create an goal layout of your liking.
@@ -131,23 +1200,54 @@ void SetGoal(int **a)
     int i, j;
     for (i=0; i<N; i++)
         for (j=0; j<N; j++)
-            a[i][j] = (i*N)+j+1;
+            a[i][j] = ((i*N)+j+1) % NTILES;    // blank in the bottom right corner
+    return;
+}
+
+// This function packs a tile configuration into a state and caches the position
+// of the blank tile
+State PackLayout(int **a)
+{
+    int i, j;
+    State s = 0;
+
+    for (i=0; i<N; i++)
+        for (j=0; j<N; j++)
+        {
+            s |= ((State)a[i][j]) << ((i*N+j)*TILEBITS);
+#ifdef BLANKSHIFT
+            if (a[i][j] == BLANK)
+                s |= ((State)(i*N+j)) << BLANKSHIFT;
+#endif
+        }
+    return(s);
+}
+
+// This function expands a state back into a tile configuration
+void UnpackLayout(State s, int **a)
+{
+    int i, j;
+
+    for (i=0; i<N; i++)
+        for (j=0; j<N; j++)
+            a[i][j] = GetTile(s, i*N+j);
     return;
 }
 
 // This function prints the 8 puzzle problem to the standard output. The blank tile
-// is represented by the tile with the number 9
-void PrintPuzzle(int **a)
+// is represented by the tile with the number 0
+void PrintPuzzle(State a)
 {
     int i, j;
+    int width = (NTILES > 10) ? 2 : 1;     // digits of the largest tile
 
     for (i=0; i<N; i++)
     {
         for (j=0; j<N; j++)
-            if (a[i][j] != 9)
-                printf("%d ", a[i][j]);
+            if (GetTile(a, i*N+j) != BLANK)
+                printf("%*d ", width, GetTile(a, i*N+j));
             else
-                printf("  ");
+                printf("%*s ", width, "");
 
         printf("\n");
     }
@@ -155,49 +1255,71 @@ void PrintPuzzle(int **a)
 }
 
 
-// This function moves the tile at location x, along the 4 possible directions
+// This function moves the blank tile along the 4 possible directions and returns
+// the resulting state. The tile it swaps with is found from the cached blank position.
 // 0 - left
 // 1 - right
 // 2 - top
 // 3 - bottom
-void MoveTile(int **a, Location x, int direction)
+static const int MoveOffset[MAXVALIDMOVES] = {-1, 1, -N, N};
+
+State MoveTile(State a, int direction)
 {
-    int temp;
+    int from = GetBlank(a);
 
-    // value of the tile at the source location
-    temp = a[x.i][x.j];
+    return(MoveBlank(a, from, from + MoveOffset[direction]));
+}
 
-    switch (direction)
-    {
-        // move tile right
-    case 0:
-        a[x.i][x.j] = a[x.i][x.j-1];
-        a[x.i][x.j-1] = temp;
-        break;
-        // move tile left
-    case 1:
-        a[x.i][x.j] = a[x.i][x.j+1];
-        a[x.i][x.j+1] = temp;
-        break;
-        // move tile top
-    case 2:
-        a[x.i][x.j] = a[x.i-1][x.j];
-        a[x.i-1][x.j] = temp;
-        break;
-        // move tile bottom
-    case 3:
-        a[x.i][x.j] = a[x.i+1][x.j];
-        a[x.i+1][x.j] = temp;
-        break;
-    }
-    return;
+// The moves of the blank from every cell, worked out by the compiler. MoveTable[p][l+1]
+// lists the moves from cell p that do not undo the last move l (-1 for none, the
+// inverse of move m is m^1), so expanding a node is one walk over a short list with
+// no tests of the board edges.
+#define MOVE_OK(p,m,l) (((m)==0 ? (p)%N > 0 : (m)==1 ? (p)%N < N-1 : (m)==2 ? (p) >= N : (p) < NTILES-N) && ((m)^1) != (l))
+#define MOVE_RANK(p,m,l) (((m) > 0 && MOVE_OK(p,0,l)) + ((m) > 1 && MOVE_OK(p,1,l)) + ((m) > 2 && MOVE_OK(p,2,l)))
+#define MOVE_IS(p,m,k,l) (MOVE_OK(p,m,l) && MOVE_RANK(p,m,l) == (k))
+#define MOVE_NTH(p,k,l) (MOVE_IS(p,0,k,l) ? 0 : MOVE_IS(p,1,k,l) ? 1 : MOVE_IS(p,2,k,l) ? 2 : MOVE_IS(p,3,k,l) ? 3 : -1)
+#define MOVE_TO(p,k,l) ((p) + (MOVE_IS(p,0,k,l) ? -1 : MOVE_IS(p,1,k,l) ? 1 : MOVE_IS(p,2,k,l) ? -N : MOVE_IS(p,3,k,l) ? N : 0))
+#define MOVE_LIST(p,l) {MOVE_OK(p,0,l) + MOVE_OK(p,1,l) + MOVE_OK(p,2,l) + MOVE_OK(p,3,l), \
+    {MOVE_NTH(p,0,l), MOVE_NTH(p,1,l), MOVE_NTH(p,2,l), MOVE_NTH(p,3,l)}, \
+    {MOVE_TO(p,0,l), MOVE_TO(p,1,l), MOVE_TO(p,2,l), MOVE_TO(p,3,l)}}
+#define MOVE_CELL(p) {MOVE_LIST(p,-1), MOVE_LIST(p,0), MOVE_LIST(p,1), MOVE_LIST(p,2), MOVE_LIST(p,3)}
+
+static const struct MoveList MoveTable[NTILES][MAXVALIDMOVES+1] =
+{
+    MOVE_CELL(0), MOVE_CELL(1), MOVE_CELL(2), MOVE_CELL(3), MOVE_CELL(4),
+    MOVE_CELL(5), MOVE_CELL(6), MOVE_CELL(7), MOVE_CELL(8),
+#if N > 3
+    MOVE_CELL(9), MOVE_CELL(10), MOVE_CELL(11), MOVE_CELL(12), MOVE_CELL(13),
+    MOVE_CELL(14), MOVE_CELL(15),
+#endif
+#if N > 4
+    MOVE_CELL(16), MOVE_CELL(17), MOVE_CELL(18), MOVE_CELL(19), MOVE_CELL(20),
+    MOVE_CELL(21), MOVE_CELL(22), MOVE_CELL(23), MOVE_CELL(24),
+#endif
+};
+
+// This function moves the blank tile from cell from to the adjacent cell to and returns
+// the resulting state
+State MoveBlank(State a, int from, int to)
+{
+    State diff;
+
+    // tile ^ blank, xor-ed into both cells swaps the tile and the blank
+    diff = ((a >> (to*TILEBITS)) & TILEMASK) ^ BLANK;
+    a ^= (diff << (from*TILEBITS)) | (diff << (to*TILEBITS));
+
+#ifdef BLANKSHIFT
+    // update the cached position of the blank tile
+    a = (a & BOARDMASK) | (((State)to) << BLANKSHIFT);
+#endif
+    return(a);
 }
 
 // This function scrambles the initial tile configuration using valid moves.
 // It keeps track of the location of the blank tile
 // It moves the blank tile along any of the valid moves a fixed number of times
 // specified by moves.
-void Scramble(int **a)
+State Scramble(State a)
 {
     int i, j;
     Location blank;
@@ -232,26 +1354,48 @@ void Scramble(int **a)
         //srand((unsigned)time(NULL));
         move = validmoves[rand() % nvalidmoves];
         // perform the move
-        MoveTile(a, blank, move);
+        a = MoveTile(a, move);
 
         nvalidmoves = 0;
         free(validmoves);
     }
+    return(a);
 }
 
 // This function determines the location of the blank tile in the puzzle
-void FindBlankTile(int **a, Location *blank)
+void FindBlankTile(State a, Location *blank)
 {
-    int i, j;
+    int p = GetBlank(a);
 
-    for (i=0; i<N; i++)
-        for (j=0; j<N; j++)
-            if (a[i][j] == 9)
-            {
-                blank->i = i;
-                blank->j = j;
-                return;
-            }
+    blank->i = p / N;
+    blank->j = p % N;
+}
+
+// This function finds the position of the cell holding 0 without looking at the cells
+// one by one: every cell is folded into its lowest bit, which then is 0 only for the blank
+int FindZeroTile(State a)
+{
+    int k;
+    State x = a;
+
+    for (k=1; k<TILEBITS; k++)
+        x |= a >> k;
+    x = ~x & LOWBITS;
+#if N == 5
+    if ((uint64_t)x == 0)
+        return((64 + __builtin_ctzll((uint64_t)(x >> 64))) / TILEBITS);
+#endif
+    return(__builtin_ctzll((uint64_t)x) / TILEBITS);
+}
+
+// This function counts the bits set in a state
+int CountTileBits(State a)
+{
+#if N == 5
+    return(__builtin_popcountll((uint64_t)a) + __builtin_popcountll((uint64_t)(a >> 64)));
+#else
+    return(__builtin_popcountll(a));
+#endif
 }
 
 // This function determines if a move is valid
@@ -284,964 +1428,5709 @@ int IsValidMove(Location blank, int move)
     return(0);
 }
 
-// This function computes the number of misplaced tiles
-int HeuristicMisplacedTiles(int **goal, int **a)
+// This function computes the number of misplaced tiles (the blank included)
+int HeuristicMisplacedTiles(State goal, State a)
 {
-    int i, j;
-    int h=0;
+    int k;
+    State d, x;
 
-    for (i=0; i<N; i++)
-        for (j=0; j<N; j++)
-            if (goal[i][j] != a[i][j])
-                h++;
-    return(h);
+    // fold every cell of the difference into its lowest bit and count them
+    d = (goal ^ a) & BOARDMASK;
+    x = d;
+    for (k=1; k<TILEBITS; k++)
+        x |= d >> k;
+    return(CountTileBits(x & LOWBITS));
 }
 
 // This function checks if the current state is the goal state
-int GoalTest(int **goal, int **a)
+int GoalTest(State goal, State a)
 {
-    int i, j;
+    int found;
 
-    for (i=0; i<N; i++)
-        for (j=0; j<N; j++)
-            if (goal[i][j] != a[i][j])
-                return(0);
-    return(1);
+    PHASE_BEGIN(PHASE_GOALTEST);
+    found = (goal == a);
+    PHASE_END(PHASE_GOALTEST);
+    return(found);
 }
 
 // This function computes sum of Manhattan distance heuristic
-int HeuristicManhattanDistance(int **goal, int **a)
+int HeuristicManhattanDistance(State goal, State a)
 {
-    // Fill in the code
-    int i, j, m, n;
+    int p, tile;
     int h=0;
-    int aij;
-    
-    for (i=0; i<N; i++){
-        for (j=0; j<N; j++){
-            for(m=0;m<N;m++){
-                for(n=0;n<N;n++){
-                    if(goal[m][n]!=9 && goal[m][n]==a[i][j])
-                        h+=abs(i-m)+abs(j-n);
-                }
-            }
-        }
+    int goalpos[NTILES];
+
+    for (p=0; p<NTILES; p++)
+        goalpos[GetTile(goal, p)] = p;
+
+    for (p=0; p<NTILES; p++)
+    {
+        tile = GetTile(a, p);
+        if (tile != BLANK)
+            h += abs(p/N - goalpos[tile]/N) + abs(p%N - goalpos[tile]%N);
     }
     return(h);
 }
 
-void PrintPath(int **a, int *path)
+// This function fills the per tile and position cost tables of all heuristics for a goal.
+// The misplaced tiles heuristic counts the blank as well, Manhattan distance does not
+void BuildHeuristicTables(struct HeuristicTables *t, State goal)
 {
-    int i;
-    Location blank;
+    int p, tile;
+    int goalpos[NTILES];
 
-    printf("path to the goal node: \n");
-    PrintPuzzle(a);
-    for (i=path[0]; i>0; i--)
+    for (p=0; p<NTILES; p++)
+        goalpos[GetTile(goal, p)] = p;
+
+    t->goal = goal;
+    t->blankrow = goalpos[BLANK]/N;
+    t->blankcol = goalpos[BLANK]%N;
+    for (tile=0; tile<NTILES; tile++)
     {
-        FindBlankTile(a, &blank);
-        MoveTile(a, blank, path[i]);
-        printf("move blank tile: ");
-        switch (path[i])
+        t->goalrow[tile] = goalpos[tile]/N;
+        t->goalcol[tile] = goalpos[tile]%N;
+    }
+    for (tile=0; tile<NTILES; tile++)
+        for (p=0; p<NTILES; p++)
         {
-            case 0: printf("left");
-                    break;
-            case 1: printf("right");
-                    break;
-            case 2: printf("top");
-                    break;
-            case 3: printf("bottom");
-                break;
+            t->cost[HEURISTIC_MISPLACED][tile][p] = (goalpos[tile] != p);
+            if (tile == BLANK)
+                t->cost[HEURISTIC_MANHATTAN][tile][p] = 0;
+            else
+                t->cost[HEURISTIC_MANHATTAN][tile][p] = abs(p/N - goalpos[tile]/N) + abs(p%N - goalpos[tile]%N);
         }
-        printf("\n");
-        PrintPuzzle(a);
+}
+
+// This function returns the heuristic value of child, generated by one move from parent
+// whose heuristic value is h. Only the moved tile and the blank changed position, so
+// this takes O(1) instead of a scan of the whole board.
+int UpdateHeuristic(const struct HeuristicTables *t, int heuristic, State parent, State child, float h)
+{
+    int from, to, tile, ch, column, a, b;
+
+    PHASE_BEGIN(PHASE_HEURISTIC);
+    from = GetBlank(parent);
+    to = GetBlank(child);
+    tile = GetTile(parent, to);     // the tile slides from to into from
+    // the tile changes column on a move along a row, only the two columns it moves between
+    // change their tiles then, and the same for rows
+    column = (from/N == to/N);
+    a = column ? from%N : from/N;
+    b = column ? to%N : to/N;
+    switch (heuristic)
+    {
+    case HEURISTIC_PDB:
+        ch = UpdatePatternHeuristic(t, parent, child, (int)h);
+        break;
+    case HEURISTIC_LINEAR:
+        ch = (int)h + t->cost[HEURISTIC_MANHATTAN][tile][from] - t->cost[HEURISTIC_MANHATTAN][tile][to]
+                    + lineconflicts[LineCode(t, child, a, column)] + lineconflicts[LineCode(t, child, b, column)]
+                    - lineconflicts[LineCode(t, parent, a, column)] - lineconflicts[LineCode(t, parent, b, column)];
+        break;
+#if N <= 4
+    case HEURISTIC_WALKING:
+        ch = (int)h + WalkingDistance(t, child, column) - WalkingDistance(t, parent, column);
+        break;
+#endif
+    case HEURISTIC_MAX:
+        ch = HeuristicMaximum(t, child);
+        break;
+    default:
+        ch = (int)h + t->cost[heuristic][tile][from] - t->cost[heuristic][tile][to]
+                    + t->cost[heuristic][BLANK][to] - t->cost[heuristic][BLANK][from];
     }
+    PHASE_END(PHASE_HEURISTIC);
+    return(ch);
 }
 
-// This function performs breadth first search
-int *BFS(int **goal, int **start)
+// This function computes a heuristic value of a configuration from scratch
+int ComputeHeuristic(const struct HeuristicTables *t, int heuristic, State goal, State a)
 {
-/*    start[0][0]=2;
-    start[0][1]=9;
-    start[0][2]=4;
-    start[1][0]=3;
-    start[1][1]=1;
-    start[1][2]=6;
-    start[2][0]=7;
-    start[2][1]=5;
-    start[2][2]=8;
-    
-    start[0][0]=4;
-    start[0][1]=1;
-    start[0][2]=2;
-    start[1][0]=9;
-    start[1][1]=8;
-    start[1][2]=7;
-    start[2][0]=6;
-    start[2][1]=3;
-    start[2][2]=5;
-*/    
+    // every search starts from a value computed here, the tables of the line heuristics
+    // are ready before any child is updated
+    if (heuristic >= HEURISTIC_LINEAR)
+        pthread_once(&linetablesonce, BuildLineTables);
+    switch (heuristic)
+    {
+    case HEURISTIC_MISPLACED:
+        return(HeuristicMisplacedTiles(goal, a));
+    case HEURISTIC_PDB:
+        return(HeuristicPatternDatabase(t->pdbs, goal, a));
+    case HEURISTIC_LINEAR:
+        return(HeuristicLinearConflict(t, a));
+#if N <= 4
+    case HEURISTIC_WALKING:
+        return(WalkingDistance(t, a, 0) + WalkingDistance(t, a, 1));
+#endif
+    case HEURISTIC_MAX:
+        return(HeuristicMaximum(t, a));
+    }
+    return(HeuristicManhattanDistance(goal, a));
+}
 
-    //////////////////////////////////////////////////////////////////// Parameters
-    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
-    float computation_time,start_time,end_time;
-    ////////////////////////////////////////////////////////////////////
-    
-    ////////////////////////////////////////////////////////////////////Computing start time
-    start_time = clock();
-    ////////////////////////////////////////////////////////////////////
-    
+// Default partitions of the tiles into patterns, the pattern of every tile (-1 for the blank)
+#if N == 3
+// all 8 tiles in one pattern: the table holds the exact distance of all 9!/2 configurations
+static const int DefaultPatterns[NTILES] = {-1, 0, 0, 0, 0, 0, 0, 0, 0};
+#elif N == 4
+// 6-6-3: {1,5,6,9,10,13} {7,8,11,12,14,15} {2,3,4}
+static const int DefaultPatterns[NTILES] = {-1, 0, 2, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 1, 1};
+#else
+// 5-5-5-5-4: one pattern per row of the goal
+static const int DefaultPatterns[NTILES] = {-1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2,
+                                            3, 3, 3, 3, 3, 4, 4, 4, 4};
+#endif
+
+// This function returns the index of a placement of k distinct tiles, pos[i] the position
+// of the i-th tile. Positions are numbered in a mixed radix system: the i-th tile can only
+// be on one of the NTILES-i cells not taken by the tiles before it.
+size_t RankPlacement(const int *pos, int k)
+{
     int i;
-    struct Node *curnode;
-    struct SearchQueueElement *cursqelement, *temphead;
-    Location blank;
-    int *path = NULL;
+    uint32_t used = 0;
+    size_t idx = 0;
 
-    // create the root node of the search tree
-    curnode = CreateNode(start);
+    for (i=0; i<k; i++)
+    {
+        idx = idx*(NTILES-i) + pos[i] - __builtin_popcount(used & ((1u << pos[i]) - 1));
+        used |= 1u << pos[i];
+    }
+    return(idx);
+}
 
-    // create the first element of the search queue
-    if (head == NULL)
+// This function is the inverse of RankPlacement
+void UnrankPlacement(size_t idx, int k, int *pos)
+{
+    int i, p, r[NTILES];
+    uint32_t used = 0;
+
+    for (i=k-1; i>=0; i--)
     {
-        cursqelement = CreateSearchQueueElement(curnode);
-        head = cursqelement;
+        r[i] = idx % (NTILES-i);
+        idx /= (NTILES-i);
+    }
+    for (i=0; i<k; i++)
+    {
+        // the r[i]-th free cell
+        for (p=0; r[i] > 0 || (used & (1u << p)); p++)
+            if (!(used & (1u << p)))
+                r[i]--;
+        pos[i] = p;
+        used |= 1u << p;
     }
+}
 
-    temphead = head;
+// This function returns 2 * the table entry of a pattern, tilepos holds the position of every tile
+int PatternExcess(const struct PatternDatabase *pdb, const int *tilepos)
+{
+    int i, pos[NTILES];
+    size_t idx;
 
-    
+    for (i=0; i<pdb->ntiles; i++)
+        pos[i] = tilepos[pdb->tiles[i]];
+    idx = RankPlacement(pos, pdb->ntiles);
+    return(2*((pdb->table[idx >> 1] >> ((idx & 1)*4)) & 0xF));
+}
 
-    while(temphead != NULL)
+// This function computes the additive pattern database heuristic of a configuration
+int HeuristicPatternDatabase(const struct PatternDatabases *pdbs, State goal, State a)
+{
+    int i, p, h;
+    int tilepos[NTILES];
+
+    for (p=0; p<NTILES; p++)
+        tilepos[GetTile(a, p)] = p;
+
+    h = HeuristicManhattanDistance(goal, a);
+    for (i=0; i<pdbs->count; i++)
+        h += PatternExcess(&pdbs->pattern[i], tilepos);
+    return(h);
+}
+
+// This function returns the pattern database heuristic of child, generated by one move from
+// parent whose heuristic value is h. Only the pattern of the moved tile is looked up again.
+int UpdatePatternHeuristic(const struct HeuristicTables *t, State parent, State child, int h)
+{
+    int p, from, to, tile;
+    int tilepos[NTILES];
+    const struct PatternDatabase *pdb;
+
+    from = GetBlank(parent);
+    to = GetBlank(child);
+    tile = GetTile(parent, to);
+    pdb = &t->pdbs->pattern[t->pdbs->patternof[tile]];
+
+    for (p=0; p<NTILES; p++)
+        tilepos[GetTile(parent, p)] = p;
+
+    h += t->cost[HEURISTIC_MANHATTAN][tile][from] - t->cost[HEURISTIC_MANHATTAN][tile][to];
+    h -= PatternExcess(pdb, tilepos);
+    tilepos[tile] = from;
+    h += PatternExcess(pdb, tilepos);
+    return(h);
+}
+
+// This function returns the code of the tiles of row line (or of column line if column is
+// set) that belong to that row (column) in the goal: one digit base N+1 per cell, the goal
+// column (row) of the tile or N for the blank and tiles of other lines
+int LineCode(const struct HeuristicTables *t, State a, int line, int column)
+{
+    int k, p, tile, code = 0;
+
+    for (k=0; k<N; k++)
     {
-        /////////////////////////////////////////// Computing parameters
-        nodes_expanded++;            
-        /////////////////////////////////////////////////////////////////        
+        p = column ? k*N + line : line*N + k;
+        tile = GetTile(a, p);
+        if (tile == BLANK || (column ? t->goalcol[tile] : t->goalrow[tile]) != line)
+            code = code*(N+1) + N;
+        else
+            code = code*(N+1) + (column ? t->goalrow[tile] : t->goalcol[tile]);
+    }
+    return(code);
+}
 
-        // check for goal
-        if (GoalTest(goal, temphead->nodeptr->layout) == 1)
-        {
-            // we have found a goal state!
-            printf("goal state found at depth: %d\n", temphead->nodeptr->g_val);
-            // path[0] - length of the path
-            // path[1:path[0]] - the moves in the path
-            path = (int *)malloc(sizeof(int));
-            path[0] = 0;
-            // traverse the path in the reverse order - from goal to root
-            // while traversing, store the blank tile moves for each step
-            curnode = temphead->nodeptr;
-            while (curnode->parent != NULL)
-            {
-                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
-                path[path[0]+1] = curnode->move;
-                path[0]++;
-                curnode = curnode->parent;
-            }
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
+// This function fills lineconflicts: of the tiles of a line that belong to it, all but
+// those of a longest sequence in goal order must leave the line and come back to let
+// the others pass, which takes at least two moves each that Manhattan distance does not
+// count
+void BuildLineConflicts()
+{
+    int code, k, j, n, longest;
+    int digits[N], run[N];
 
-            return(path);
-        }
-        FindBlankTile(temphead->nodeptr->layout, &blank);
-        // compute the children of the current node
-        for (i=0; i<MAXVALIDMOVES; i++)
+    for (code=0; code<LINECODES; code++)
+    {
+        n = 0;
+        for (k=N-1, j=code; k>=0; k--, j/=N+1)
+            if (j%(N+1) != N)
+                digits[n++] = j%(N+1);
+        // the digits come out last cell first, a longest decreasing run of them is a
+        // longest increasing run of the line
+        longest = 0;
+        for (k=0; k<n; k++)
         {
-            if (IsValidMove(blank, i) == 1)
-            {
-                int lastmove = temphead->nodeptr->move;
-                if( (i==0 && lastmove==1) || (i==1 && lastmove==0) || (i==2 && lastmove==3) || (i==3 && lastmove==2) ) continue;
-                /////////////////////////////////////////////////////Computing nodes generated
-                nodes_generated++;
-                /////////////////////////////////////////////////////
-                curnode = CreateNode(temphead->nodeptr->layout);
-                MoveTile(curnode->layout, blank, i);
-                curnode->move = i;
-                curnode->g_val = temphead->nodeptr->g_val+1;
-                ////////////////////////////////////////////////////Computing max depth reached
-                if(max_depth < curnode->g_val){
-                    max_depth = curnode->g_val;
-                }
-                ////////////////////////////////////////////////////
-                curnode->parent = temphead->nodeptr;
-                cursqelement = CreateSearchQueueElement(curnode);
-                AppendSearchQueueElementToEnd(cursqelement);
-            }
-        }
-        
-        /////////////////////////////////////////////// Computing Memory consumed
-        if(memory_consumed < nodes_generated-nodes_expanded){
-            memory_consumed = nodes_generated-nodes_expanded;
+            run[k] = 1;
+            for (j=0; j<k; j++)
+                if (digits[j] > digits[k] && run[j]+1 > run[k])
+                    run[k] = run[j]+1;
+            if (longest < run[k])
+                longest = run[k];
         }
-        ///////////////////////////////////////////////
-        temphead = temphead->next;
+        lineconflicts[code] = 2*(n - longest);
     }
-    
-    /////////////////////////////////////////// Printing parameters
-    end_time = clock();
-    computation_time = end_time - start_time;
-    printf("Nodes Expanded : %d\n",nodes_expanded);
-    printf("Nodes Generated : %d\n",nodes_generated); 
-    printf("Max Depth Reached : %d\n", max_depth);
-    printf("Memory Consumed : %d\n", memory_consumed);
-    printf("Computation Time : %f\n",computation_time);
-    ////////////////////////////////////////////////////////////////////
-    
-    return(path);
 }
 
-// This function performs Depth first search
-int *DFS(int **goal, int **start)
+// This function computes Manhattan distance plus the linear conflicts of every row and column
+int HeuristicLinearConflict(const struct HeuristicTables *t, State a)
 {
-/*    start[0][0]=2;
-    start[0][1]=9;
-    start[0][2]=4;
-    start[1][0]=3;
-    start[1][1]=1;
-    start[1][2]=6;
-    start[2][0]=7;
-    start[2][1]=5;
-    start[2][2]=8;
-    
-    start[0][0]=4;
-    start[0][1]=1;
-    start[0][2]=2;
-    start[1][0]=9;
-    start[1][1]=8;
-    start[1][2]=7;
-    start[2][0]=6;
-    start[2][1]=3;
-    start[2][2]=5;
-*/    
-    //////////////////////////////////////////////////////////////////// Parameters
-    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
-    float computation_time,start_time,end_time;
-    ////////////////////////////////////////////////////////////////////
-    
-    ////////////////////////////////////////////////////////////////////Computing start time
-    start_time = clock();
-    ////////////////////////////////////////////////////////////////////
+    int p, h = 0;
+
+    for (p=0; p<NTILES; p++)
+        h += t->cost[HEURISTIC_MANHATTAN][GetTile(a, p)][p];
+    for (p=0; p<N; p++)
+        h += lineconflicts[LineCode(t, a, p, 0)] + lineconflicts[LineCode(t, a, p, 1)];
+    return(h);
+}
+
+#if N <= 4
+// This function returns the key of a walking distance state for the goal line target of the
+// blank: the line of the blank and, for every line, how many of its tiles belong to each goal
+// line. The count of the goal line of the blank follows from the others and is left out.
+uint64_t WalkingKey(int blankline, int counts[N][N], int target)
+{
+    int line, group, shift = 3;
+    uint64_t key = blankline;
+
+    for (line=0; line<N; line++)
+        for (group=0; group<N; group++)
+            if (group != target)
+            {
+                key |= (uint64_t)counts[line][group] << shift;
+                shift += 3;
+            }
+    return(key);
+}
 
+// This function finds the slot of a key in the hash table of a walking distance table
+// returns the slot, which holds -1 if the key is not in the table
+int WalkingSlot(const struct WalkingDistance *wd, uint64_t key)
+{
     int i;
-    struct Node *curnode;
-    struct SearchQueueElement *cursqelement, *temphead;
-    Location blank;
-    int *path = NULL;
 
-    // create the root node of the search tree
-    curnode = CreateNode(start);
+    for (i=HashState(key) & wd->mask; wd->slots[i] >= 0 && wd->keys[wd->slots[i]] != key; i=(i+1) & wd->mask)
+        ;
+    return(i);
+}
 
-    // create the first element of the search queue
-    if (head == NULL)
+// This function adds a key to a walking distance table at the distance given, growing the
+// table when it is half full
+void AddWalkingState(struct WalkingDistance *wd, uint64_t key, int distance)
+{
+    int i;
+
+    if (2*(wd->count+1) > wd->mask+1)
     {
-        cursqelement = CreateSearchQueueElement(curnode);
-        head = cursqelement;
+        wd->mask = wd->mask ? 2*wd->mask+1 : 1023;
+        wd->slots = (int *)realloc(wd->slots, sizeof(int)*(wd->mask+1));
+        wd->keys = (uint64_t *)realloc(wd->keys, sizeof(uint64_t)*(wd->mask+1)/2);
+        wd->distance = (unsigned char *)realloc(wd->distance, (wd->mask+1)/2);
+        memset(wd->slots, -1, sizeof(int)*(wd->mask+1));
+        for (i=0; i<wd->count; i++)
+            wd->slots[WalkingSlot(wd, wd->keys[i])] = i;
     }
+    wd->slots[WalkingSlot(wd, key)] = wd->count;
+    wd->keys[wd->count] = key;
+    wd->distance[wd->count++] = distance;
+}
 
-    temphead = head;
+// This function builds the walking distance table for the goal line target of the blank by
+// a breadth first search from the goal, where every line holds its own tiles. A move takes
+// a tile of any goal line from a line next to the blank into the line of the blank.
+void BuildWalkingDistance(struct WalkingDistance *wd, int target)
+{
+    int i, line, group, next, step;
+    int counts[N][N];
+    uint64_t key;
 
-    
+    memset(wd, 0, sizeof(*wd));
+    memset(counts, 0, sizeof(counts));
+    for (line=0; line<N; line++)
+        counts[line][line] = N - (line == target);
+    AddWalkingState(wd, WalkingKey(target, counts, target), 0);
 
-    while(temphead != NULL)
+    for (i=0; i<wd->count; i++)
     {
-        /////////////////////////////////////////// Computing parameters
-        nodes_expanded++;            
-        /////////////////////////////////////////////////////////////////        
-        head = head->next;
-        // check for goal
-        if (GoalTest(goal, temphead->nodeptr->layout) == 1)
+        // unpack the counts, the blank line holds one tile less than the others
+        key = wd->keys[i] >> 3;
+        for (line=0; line<N; line++)
         {
-            // we have found a goal state!
-            printf("goal state found at depth: %d\n", temphead->nodeptr->g_val);
-            // path[0] - length of the path
-            // path[1:path[0]] - the moves in the path
-            path = (int *)malloc(sizeof(int));
-            path[0] = 0;
-            // traverse the path in the reverse order - from goal to root
-            // while traversing, store the blank tile moves for each step
-            curnode = temphead->nodeptr;
-            while (curnode->parent != NULL)
-            {
-                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
-                path[path[0]+1] = curnode->move;
-                path[0]++;
-                curnode = curnode->parent;
-            }
-            
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
-
-            return(path);
-        }
-        FindBlankTile(temphead->nodeptr->layout, &blank);
-        // compute the children of the current node
-        if (temphead->nodeptr->g_val > MAX_DEPTH){
-            struct SearchQueueElement* temp;
-            temp = temphead;
-            temphead = head;
-            free(temp);
-            continue;
+            counts[line][target] = N - (line == (int)(wd->keys[i] & 7));
+            for (group=0; group<N; group++)
+                if (group != target)
+                {
+                    counts[line][group] = key & 7;
+                    counts[line][target] -= counts[line][group];
+                    key >>= 3;
+                }
         }
-        for (i=0; i<MAXVALIDMOVES; i++)
+        line = wd->keys[i] & 7;
+        for (step=-1; step<=1; step+=2)
         {
-            if (IsValidMove(blank, i) == 1)
+            next = line + step;
+            if (next < 0 || next >= N)
+                continue;
+            for (group=0; group<N; group++)
             {
-                int lastmove = temphead->nodeptr->move;
-                if( (i==0 && lastmove==1) || (i==1 && lastmove==0) || (i==2 && lastmove==3) || (i==3 && lastmove==2) ) continue;
-                /////////////////////////////////////////////////////Computing nodes generated
-                nodes_generated++;
-                /////////////////////////////////////////////////////
-                curnode = CreateNode(temphead->nodeptr->layout);
-                MoveTile(curnode->layout, blank, i);
-                curnode->move = i;
-                curnode->g_val = temphead->nodeptr->g_val+1;
-                ////////////////////////////////////////////////////Computing max depth reached
-                if(max_depth < curnode->g_val){
-                    max_depth = curnode->g_val;
-                }
-                ////////////////////////////////////////////////////
-                curnode->parent = temphead->nodeptr;
-                cursqelement = CreateSearchQueueElement(curnode);
-                AppendSearchQueueElementToFront(cursqelement);
+                if (counts[next][group] == 0)
+                    continue;
+                counts[next][group]--;
+                counts[line][group]++;
+                key = WalkingKey(next, counts, target);
+                if (wd->slots[WalkingSlot(wd, key)] < 0)
+                    AddWalkingState(wd, key, wd->distance[i]+1);
+                counts[next][group]++;
+                counts[line][group]--;
             }
         }
-        /////////////////////////////////////////////// Computing Memory consumed
-        if(memory_consumed < nodes_generated-nodes_expanded){
-            memory_consumed = nodes_generated-nodes_expanded;
-        }
-        ///////////////////////////////////////////////
-        struct SearchQueueElement* temp;
-        temp = temphead;
-        temphead = head;
-        free(temp);        
     }
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
-    return(path);
 }
 
-// This function performs Greedy best first search
-int *GBEFS(int **goal, int **start)
+// This function builds the walking distance tables for every goal line of the blank
+void BuildWalkingDistances()
 {
-/*    start[0][0]=2;
-    start[0][1]=9;
-    start[0][2]=4;
-    start[1][0]=3;
-    start[1][1]=1;
-    start[1][2]=6;
-    start[2][0]=7;
-    start[2][1]=5;
-    start[2][2]=8;
-    
-    start[0][0]=4;
-    start[0][1]=1;
-    start[0][2]=2;
-    start[1][0]=9;
-    start[1][1]=8;
-    start[1][2]=7;
-    start[2][0]=6;
-    start[2][1]=3;
-    start[2][2]=5;
-*/    
-    
-    //////////////////////////////////////////////////////////////////// Parameters
-    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
-    float computation_time,start_time,end_time;
-    ////////////////////////////////////////////////////////////////////
-    
-    ////////////////////////////////////////////////////////////////////Computing start time
-    start_time = clock();
-    ////////////////////////////////////////////////////////////////////
-        
-    int i;
-    struct Node *curnode;
-    struct SearchQueueElement *cursqelement, *temphead;
-    Location blank;
-    int *path = NULL;
+    int target;
 
-    // create the root node of the search tree
-    curnode = CreateNode(start);
+    for (target=0; target<N; target++)
+        BuildWalkingDistance(&walkingdistance[target], target);
+}
 
-    // create the first element of the search queue
-    if (head == NULL)
+// This function returns the walking distance of a configuration along the rows, or along
+// the columns if column is set
+int WalkingDistance(const struct HeuristicTables *t, State a, int column)
+{
+    int p, tile, blank = 0;
+    int counts[N][N];
+    const struct WalkingDistance *wd = &walkingdistance[column ? t->blankcol : t->blankrow];
+
+    memset(counts, 0, sizeof(counts));
+    for (p=0; p<NTILES; p++)
     {
-        cursqelement = CreateSearchQueueElement(curnode);
-        head = cursqelement;
+        tile = GetTile(a, p);
+        if (tile == BLANK)
+            blank = column ? p%N : p/N;
+        else if (column)
+            counts[p%N][t->goalcol[tile]]++;
+        else
+            counts[p/N][t->goalrow[tile]]++;
     }
+    return(wd->distance[wd->slots[WalkingSlot(wd, WalkingKey(blank, counts, column ? t->blankcol : t->blankrow))]]);
+}
+#endif
 
-    temphead = head;    
-    while(temphead != NULL)
-    {   
-        //////////////////////////////////////////////////////////
-        nodes_expanded++;
-        //////////////////////////////////////////////////////////
-        
-        head = head->next;
-//        printf("%p\n",head);
-        // check for goal
-        if (GoalTest(goal, temphead->nodeptr->layout) == 1)
+// This function builds the tables shared by the line heuristics, once for all threads
+void BuildLineTables()
+{
+    BuildLineConflicts();
+#if N <= 4
+    BuildWalkingDistances();
+#endif
+}
+
+// This function computes the maximum of linear conflict, walking distance and the pattern
+// databases if they are loaded, each of them is a lower bound
+int HeuristicMaximum(const struct HeuristicTables *t, State a)
+{
+    int h, other;
+
+    h = HeuristicLinearConflict(t, a);
+#if N <= 4
+    other = WalkingDistance(t, a, 0) + WalkingDistance(t, a, 1);
+    if (h < other)
+        h = other;
+#endif
+    if (t->pdbs != NULL && h < (other = HeuristicPatternDatabase(t->pdbs, t->goal, a)))
+        h = other;
+    return(h);
+}
+
+// cells in the first and in the last column of the board
+#if N == 3
+#define FIRSTCOLUMN 0x049u
+#define LASTCOLUMN 0x124u
+#elif N == 4
+#define FIRSTCOLUMN 0x1111u
+#define LASTCOLUMN 0x8888u
+#else
+#define FIRSTCOLUMN 0x108421u
+#define LASTCOLUMN 0x1084210u
+#endif
+
+// This function returns the cells of mask together with their horizontal and vertical neighbours
+uint32_t GrowCells(uint32_t mask)
+{
+    return((mask | ((mask << 1) & ~FIRSTCOLUMN) | ((mask >> 1) & ~LASTCOLUMN) | (mask << N) | (mask >> N))
+           & ((1u << NTILES) - 1));
+}
+
+// This function returns the region of free cells the blank can reach from cell
+uint32_t FloodRegion(int cell, uint32_t occupied)
+{
+    uint32_t region = 1u << cell, grown;
+
+    while ((grown = GrowCells(region) & ~occupied) != region)
+        region = grown;
+    return(region);
+}
+
+// This function fills one pattern table with a breadth first sweep from the goal. An abstract
+// state is a placement of the pattern tiles plus the region of free cells the blank is in; the
+// blank moves freely inside its region and every move of a pattern tile costs 1, so the sweep
+// goes from region to region one level per pattern move.
+// returns 0 if there is not enough memory
+int BuildPatternTable(const struct PatternDatabase *pdb, const int *goalpos, unsigned char *table)
+{
+    int i, c, from, k = pdb->ntiles;
+    int pos[NTILES];
+    unsigned char *best;            // distance of every placement, 0xFF if not reached yet
+    unsigned char *visited;         // one bit per placement and blank cell
+    uint64_t *cur, *next = NULL, *swap;
+    size_t ncur = 0, nnext = 0, capcur = 1024, capnext = 0, e, idx, nidx, bit;
+    uint32_t occupied, region, nregion, targets;
+    int depth, md, r;
+
+    best = (unsigned char *)malloc(pdb->entries);
+    visited = (unsigned char *)calloc((pdb->entries*NTILES+7)/8, 1);
+    cur = (uint64_t *)malloc(sizeof(uint64_t)*capcur);
+    if (best == NULL || visited == NULL || cur == NULL)
+    {
+        free(best);
+        free(visited);
+        free(cur);
+        return(0);
+    }
+    memset(best, 0xFF, pdb->entries);
+
+    // start from the goal placement, marking every cell of the blank region as visited
+    occupied = 0;
+    for (i=0; i<k; i++)
+    {
+        pos[i] = goalpos[pdb->tiles[i]];
+        occupied |= 1u << pos[i];
+    }
+    idx = RankPlacement(pos, k);
+    region = FloodRegion(goalpos[BLANK], occupied);
+    for (c=0; c<NTILES; c++)
+        if (region & (1u << c))
         {
-            // we have found a goal state!
-            printf("goal state found at depth: %d\n", temphead->nodeptr->g_val);
-            // path[0] - length of the path
-            // path[1:path[0]] - the moves in the path
-            path = (int *)malloc(sizeof(int));
-            path[0] = 0;
-            // traverse the path in the reverse order - from goal to root
-            // while traversing, store the blank tile moves for each step
-            curnode = temphead->nodeptr;
-            while (curnode->parent != NULL)
+            bit = idx*NTILES + c;
+            visited[bit >> 3] |= 1 << (bit & 7);
+        }
+    cur[ncur++] = idx*NTILES + goalpos[BLANK];
+
+    for (depth=0; ncur > 0; depth++)
+    {
+        nnext = 0;
+        for (e=0; e<ncur; e++)
+        {
+            idx = cur[e] / NTILES;
+            if (best[idx] > depth)
+                best[idx] = depth;
+
+            UnrankPlacement(idx, k, pos);
+            occupied = 0;
+            for (i=0; i<k; i++)
+                occupied |= 1u << pos[i];
+            region = FloodRegion(cur[e] % NTILES, occupied);
+
+            // slide every pattern tile next to the region into it, the blank takes its cell
+            for (i=0; i<k; i++)
             {
-                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
-                path[path[0]+1] = curnode->move;
-                path[0]++;
-                curnode = curnode->parent;
+                from = pos[i];
+                targets = GrowCells(1u << from) & region;
+                for (c=0; c<NTILES; c++)
+                {
+                    if (!(targets & (1u << c)))
+                        continue;
+                    pos[i] = c;
+                    nidx = RankPlacement(pos, k);
+                    bit = nidx*NTILES + from;
+                    if (visited[bit >> 3] & (1 << (bit & 7)))
+                        continue;
+
+                    nregion = FloodRegion(from, (occupied & ~(1u << from)) | (1u << c));
+                    for (r=0; r<NTILES; r++)
+                        if (nregion & (1u << r))
+                        {
+                            bit = nidx*NTILES + r;
+                            visited[bit >> 3] |= 1 << (bit & 7);
+                        }
+                    if (nnext == capnext)
+                    {
+                        capnext = capnext ? 2*capnext : 1024;
+                        next = (uint64_t *)realloc(next, sizeof(uint64_t)*capnext);
+                    }
+                    next[nnext++] = nidx*NTILES + from;
+                }
+                pos[i] = from;
             }
+        }
+        swap = cur; cur = next; next = swap;
+        e = capcur; capcur = capnext; capnext = e;
+        ncur = nnext;
+    }
 
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
+    // store (distance - Manhattan distance)/2 of every placement
+    memset(table, 0, (pdb->entries+1)/2);
+    for (idx=0; idx<pdb->entries; idx++)
+    {
+        if (best[idx] == 0xFF)
+            continue;       // placement can not be reached (only with all tiles in one pattern)
+        UnrankPlacement(idx, k, pos);
+        md = 0;
+        for (i=0; i<k; i++)
+            md += abs(pos[i]/N - goalpos[pdb->tiles[i]]/N) + abs(pos[i]%N - goalpos[pdb->tiles[i]]%N);
+        r = (best[idx] - md)/2;
+        table[idx >> 1] |= (r > 15 ? 15 : r) << ((idx & 1)*4);
+    }
 
-            return(path);
+    free(cur);
+    free(next);
+    free(best);
+    free(visited);
+    return(1);
+}
+
+// This function fills the pattern list of a pattern database from the pattern of every tile
+void SetupPatterns(struct PatternDatabases *pdbs, const int *patternof)
+{
+    int i, tile;
+
+    pdbs->count = 0;
+    for (tile=0; tile<NTILES; tile++)
+    {
+        pdbs->patternof[tile] = patternof[tile];
+        if (patternof[tile] >= pdbs->count)
+            pdbs->count = patternof[tile]+1;
+    }
+    for (i=0; i<pdbs->count; i++)
+    {
+        pdbs->pattern[i].ntiles = 0;
+        pdbs->pattern[i].entries = 1;
+    }
+    for (tile=1; tile<NTILES; tile++)
+    {
+        struct PatternDatabase *pdb = &pdbs->pattern[patternof[tile]];
+        pdb->entries *= NTILES - pdb->ntiles;
+        pdb->tiles[pdb->ntiles++] = tile;
+    }
+}
+
+// size of the table of a pattern in the file
+#define PatternTableBytes(pdb) ((((pdb)->entries+1)/2 + 7) & ~(size_t)7)
+
+// This function builds the tables of the default patterns for a goal and writes them to a file.
+// The tables only depend on the patterns and the goal, building is deterministic.
+// returns 0 on failure
+int BuildPatternDatabases(const char *filename, State goal)
+{
+    int i, p;
+    FILE *fp;
+    unsigned char *table;
+    struct PatternDatabases pdbs;
+    struct PatternFileHeader header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "P1PDB01", 8);
+    header.n = N;
+    for (p=0; p<NTILES; p++)
+    {
+        header.goalpos[GetTile(goal, p)] = p;
+        header.patternof[p] = DefaultPatterns[p];
+    }
+    SetupPatterns(&pdbs, DefaultPatterns);
+    header.count = pdbs.count;
+
+    if ((fp = fopen(filename, "wb")) == NULL)
+    {
+        perror(filename);
+        return(0);
+    }
+    fwrite(&header, sizeof(header), 1, fp);
+    for (i=0; i<pdbs.count; i++)
+    {
+        printf("building pattern %d (%d tiles, %zu entries)\n", i, pdbs.pattern[i].ntiles, pdbs.pattern[i].entries);
+        table = (unsigned char *)calloc(PatternTableBytes(&pdbs.pattern[i]), 1);
+        if (table == NULL || BuildPatternTable(&pdbs.pattern[i], header.goalpos, table) == 0)
+        {
+            fprintf(stderr, "out of memory building pattern %d\n", i);
+            free(table);
+            fclose(fp);
+            return(0);
         }
-        FindBlankTile(temphead->nodeptr->layout, &blank);
-        // compute the children of the current node
-        if (temphead->nodeptr->g_val > MAX_DEPTH){
-            struct SearchQueueElement* temp;
-            temp = temphead;
-            temphead = head;
-            free(temp);
-            continue;
+        fwrite(table, PatternTableBytes(&pdbs.pattern[i]), 1, fp);
+        free(table);
+    }
+    if (fclose(fp) != 0)
+    {
+        perror(filename);
+        return(0);
+    }
+    return(1);
+}
+
+// This function maps a pattern database file built by BuildPatternDatabases. The tables are
+// used straight from the mapping, so loading takes no time regardless of their size.
+// returns 0 if the file can not be used for this board size and goal
+int LoadPatternDatabases(struct PatternDatabases *pdbs, const char *filename, State goal)
+{
+    int i, p, k, fd;
+    struct stat st;
+    size_t offset, entries;
+    const struct PatternFileHeader *header;
+
+    memset(pdbs, 0, sizeof(*pdbs));
+    if ((fd = open(filename, O_RDONLY)) < 0 || fstat(fd, &st) < 0)
+    {
+        LOAD_ERROR("%s: %s\n", filename, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return(0);
+    }
+    pdbs->mapsize = st.st_size;
+    pdbs->map = mmap(NULL, pdbs->mapsize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pdbs->map == MAP_FAILED)
+    {
+        LOAD_ERROR("%s: %s\n", filename, strerror(errno));
+        memset(pdbs, 0, sizeof(*pdbs));
+        return(0);
+    }
+
+    header = (const struct PatternFileHeader *)pdbs->map;
+    if (pdbs->mapsize < sizeof(*header) || memcmp(header->magic, "P1PDB01", 8) != 0 || header->n != N)
+    {
+        LOAD_ERROR("%s: not a pattern database for a %dx%d board\n", filename, N, N);
+        FreePatternDatabases(pdbs);
+        return(0);
+    }
+    for (p=0; p<NTILES; p++)
+        if (header->goalpos[GetTile(goal, p)] != p)
+        {
+            LOAD_ERROR("%s: pattern database was built for a different goal\n", filename);
+            FreePatternDatabases(pdbs);
+            return(0);
         }
-        for (i=0; i<MAXVALIDMOVES; i++)
+
+    // the file names the patterns, a damaged one must not index past them or overflow the
+    // number of entries of a table: the blank belongs to none, every other tile to one of
+    // at most NTILES-1, and every table fits in the file
+    for (p=0; p<NTILES; p++)
+        if (p == 0 ? header->patternof[p] != -1 : (header->patternof[p] < 0 || header->patternof[p] >= NTILES-1))
         {
-            if (IsValidMove(blank, i) == 1)
+            LOAD_ERROR("%s: tile %d has no valid pattern\n", filename, p);
+            FreePatternDatabases(pdbs);
+            return(0);
+        }
+    for (i=0; i<NTILES-1; i++)
+        for (p=1, k=0, entries=1; p<NTILES; p++)
+            if (header->patternof[p] == i)
             {
-                int lastmove = temphead->nodeptr->move;
-                if( (i==0 && lastmove==1) || (i==1 && lastmove==0) || (i==2 && lastmove==3) || (i==3 && lastmove==2) ) continue;
-                ///////////////////////////////////////////////////////////
-                nodes_generated++;
-                ///////////////////////////////////////////////////////////
-                curnode = CreateNode(temphead->nodeptr->layout);
-                MoveTile(curnode->layout, blank, i);
-                curnode->move = i;
-                curnode->g_val = temphead->nodeptr->g_val+1;
-                ////////////////////////////////////////////////////Computing max depth reached
-                if(max_depth < curnode->g_val){
-                    max_depth = curnode->g_val;
+                if (entries > 2*pdbs->mapsize/(NTILES-k))      // two entries per byte
+                {
+                    LOAD_ERROR("%s: truncated pattern database\n", filename);
+                    FreePatternDatabases(pdbs);
+                    return(0);
                 }
-                ////////////////////////////////////////////////////
-                curnode->h_val = HeuristicMisplacedTiles(goal,curnode->layout);
-                curnode->parent = temphead->nodeptr;
-                cursqelement = CreateSearchQueueElement(curnode);
-                cursqelement->next = NULL;
-                InsertSearchQueueElementPriorityh(cursqelement);
+                entries *= NTILES - k++;
             }
-        }
-        /////////////////////////////////////////////// Computing Memory consumed
-        if(memory_consumed < nodes_generated-nodes_expanded){
-            memory_consumed = nodes_generated-nodes_expanded;
-        }
-        ///////////////////////////////////////////////
-        struct SearchQueueElement* temp;
-        temp = temphead;
-        temphead = head;
-        free(temp);
+
+    SetupPatterns(pdbs, header->patternof);
+    offset = sizeof(*header);
+    for (i=0; i<pdbs->count; i++)
+    {
+        pdbs->pattern[i].table = (const unsigned char *)pdbs->map + offset;
+        offset += PatternTableBytes(&pdbs->pattern[i]);
     }
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
-    return(path);
+    if (offset > pdbs->mapsize)
+    {
+        LOAD_ERROR("%s: truncated pattern database\n", filename);
+        FreePatternDatabases(pdbs);
+        return(0);
+    }
+    return(1);
 }
 
-// This function performs A* search
-int *AStar(int **goal, int **start)
+void FreePatternDatabases(struct PatternDatabases *pdbs)
 {
-/*    start[0][0]=2;
-    start[0][1]=9;
-    start[0][2]=4;
-    start[1][0]=3;
-    start[1][1]=1;
-    start[1][2]=6;
-    start[2][0]=7;
-    start[2][1]=5;
-    start[2][2]=8;
-    
-    start[0][0]=4;
-    start[0][1]=1;
-    start[0][2]=2;
-    start[1][0]=9;
-    start[1][1]=8;
-    start[1][2]=7;
-    start[2][0]=6;
-    start[2][1]=3;
-    start[2][2]=5;
-*/
-    //////////////////////////////////////////////////////////////////// Parameters
-    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
-    float computation_time,start_time,end_time;
-    ////////////////////////////////////////////////////////////////////
-    
-    ////////////////////////////////////////////////////////////////////Computing start time
-    start_time = clock();
-    ////////////////////////////////////////////////////////////////////
+    if (pdbs->map != NULL)
+        munmap(pdbs->map, pdbs->mapsize);
+    memset(pdbs, 0, sizeof(*pdbs));
+}
 
-    int i;
-    struct Node *curnode;
-    struct SearchQueueElement *cursqelement, *temphead;
-    Location blank;
-    int *path = NULL;
+// This function returns the slot of a configuration in the distance oracle: the rank of
+// the positions of all tiles, halved. Ranks 2r and 2r+1 differ only in the order of the
+// last two tiles, and of two configurations that differ by swapping two tiles only one
+// can reach the goal, so the halved rank numbers the 181440 reachable ones without gaps.
+size_t OracleIndex(State a)
+{
+    int p, tilepos[NTILES];
 
-    // create the root node of the search tree
-    curnode = CreateNode(start);
+    for (p=0; p<NTILES; p++)
+        tilepos[GetTile(a, p)] = p;
+    return(RankPlacement(tilepos, NTILES) >> 1);
+}
 
-    // create the first element of the search queue
-    if (head == NULL)
+// This function returns the optimal distance of a configuration to the goal, modulo 16
+int OracleDistance(const struct DistanceOracle *o, State a)
+{
+    size_t idx = OracleIndex(a);
+
+    return((o->table[idx >> 1] >> ((idx & 1)*4)) & 0xF);
+}
+
+// This function finds the optimal distance of every configuration of the 8-puzzle with a
+// breadth first search from the goal and writes the distances to a file. An entry only
+// holds the distance modulo 16: a move always changes the distance by exactly 1, so that is
+// enough to tell the neighbours that are closer to the goal from those that are not.
+// returns 0 on failure
+int BuildDistanceOracle(const char *filename, State goal)
+{
+#if N == 3
+    int i, p, d, from;
+    FILE *fp;
+    State *states, parent, child;
+    size_t nstates = 0, next, idx;
+    unsigned char *distance, *table;
+    const struct MoveList *successors;
+    struct OracleFileHeader header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "P1ORC01", 8);
+    header.n = N;
+    for (p=0; p<NTILES; p++)
+        header.goalpos[GetTile(goal, p)] = p;
+
+    states = (State *)malloc(sizeof(State)*EIGHT_PUZZLE_STATES);
+    distance = (unsigned char *)malloc(EIGHT_PUZZLE_STATES);
+    table = (unsigned char *)calloc(ORACLE_TABLE_BYTES, 1);
+    if (states == NULL || distance == NULL || table == NULL)
     {
-        cursqelement = CreateSearchQueueElement(curnode);
-        head = cursqelement;
+        fprintf(stderr, "out of memory building the distance oracle\n");
+        free(states);
+        free(distance);
+        free(table);
+        return(0);
+    }
+    memset(distance, 0xFF, EIGHT_PUZZLE_STATES);
+    states[nstates++] = goal;
+    distance[OracleIndex(goal)] = 0;
+    for (next=0; next<nstates; next++)
+    {
+        parent = states[next];
+        d = distance[OracleIndex(parent)];
+        from = GetBlank(parent);
+        successors = &MoveTable[from][0];
+        for (i=0; i<successors->count; i++)
+        {
+            child = MoveBlank(parent, from, successors->to[i]);
+            idx = OracleIndex(child);
+            if (distance[idx] != 0xFF)
+                continue;
+            distance[idx] = d+1;
+            states[nstates++] = child;
+        }
     }
+    for (idx=0; idx<EIGHT_PUZZLE_STATES; idx++)
+        table[idx >> 1] |= (distance[idx] & 0xF) << ((idx & 1)*4);
+    printf("distance oracle: %zu configurations, longest distance %d\n", nstates, d);
+    free(states);
+    free(distance);
 
-    temphead = head;    
-    while(temphead != NULL)
+    if ((fp = fopen(filename, "wb")) == NULL)
     {
-        ///////////////////////////////////////////////////////////////////////////////
-        nodes_expanded++;
-        ///////////////////////////////////////////////////////////////////////////////
-        
-        head = head->next;
-//        printf("%p\n",head);
-        // check for goal
-        if (GoalTest(goal, temphead->nodeptr->layout) == 1)
+        perror(filename);
+        free(table);
+        return(0);
+    }
+    fwrite(&header, sizeof(header), 1, fp);
+    fwrite(table, ORACLE_TABLE_BYTES, 1, fp);
+    free(table);
+    if (fclose(fp) != 0)
+    {
+        perror(filename);
+        return(0);
+    }
+    return(1);
+#else
+    (void)filename;
+    (void)goal;
+    fprintf(stderr, "the distance oracle is only for the 8-puzzle\n");
+    return(0);
+#endif
+}
+
+// This function maps a distance oracle file built by BuildDistanceOracle
+// returns 0 if the file can not be used for this board size and goal
+int LoadDistanceOracle(struct DistanceOracle *o, const char *filename, State goal)
+{
+    int p, fd;
+    struct stat st;
+    const struct OracleFileHeader *header;
+
+    memset(o, 0, sizeof(*o));
+    if ((fd = open(filename, O_RDONLY)) < 0 || fstat(fd, &st) < 0)
+    {
+        perror(filename);
+        if (fd >= 0)
+            close(fd);
+        return(0);
+    }
+    o->mapsize = st.st_size;
+    o->map = mmap(NULL, o->mapsize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (o->map == MAP_FAILED)
+    {
+        perror(filename);
+        memset(o, 0, sizeof(*o));
+        return(0);
+    }
+
+    header = (const struct OracleFileHeader *)o->map;
+    if (o->mapsize < sizeof(*header) + ORACLE_TABLE_BYTES || memcmp(header->magic, "P1ORC01", 8) != 0 || header->n != N || N != 3)
+    {
+        fprintf(stderr, "%s: not a distance oracle for a %dx%d board\n", filename, N, N);
+        FreeDistanceOracle(o);
+        return(0);
+    }
+    for (p=0; p<NTILES; p++)
+        if (header->goalpos[GetTile(goal, p)] != p)
         {
-            // we have found a goal state!
-            printf("goal state found at depth: %d\n", temphead->nodeptr->g_val);
-            // path[0] - length of the path
-            // path[1:path[0]] - the moves in the path
-            path = (int *)malloc(sizeof(int));
-            path[0] = 0;
-            // traverse the path in the reverse order - from goal to root
-            // while traversing, store the blank tile moves for each step
-            curnode = temphead->nodeptr;
-            while (curnode->parent != NULL)
-            {
-                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
-                path[path[0]+1] = curnode->move;
-                path[0]++;
-                curnode = curnode->parent;
-            }
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
-            return(path);
+            fprintf(stderr, "%s: distance oracle was built for a different goal\n", filename);
+            FreeDistanceOracle(o);
+            return(0);
         }
-        FindBlankTile(temphead->nodeptr->layout, &blank);
+    o->table = (const unsigned char *)o->map + sizeof(*header);
+    return(1);
+}
+
+void FreeDistanceOracle(struct DistanceOracle *o)
+{
+    if (o->map != NULL)
+        munmap(o->map, o->mapsize);
+    memset(o, 0, sizeof(*o));
+}
+
+void PrintPath(State a, int *path)
+{
+    int i;
+
+    printf("path to the goal node: \n");
+    PrintPuzzle(a);
+    for (i=path[0]; i>0; i--)
+    {
+        a = MoveTile(a, path[i]);
+        printf("move blank tile: ");
+        switch (path[i])
+        {
+            case 0: printf("left");
+                    break;
+            case 1: printf("right");
+                    break;
+            case 2: printf("top");
+                    break;
+            case 3: printf("bottom");
+                break;
+        }
+        printf("\n");
+        PrintPuzzle(a);
+    }
+}
+
+// This function reads a tile configuration from text, the N*N tiles in row major order
+// separated by blanks or commas. returns 0 if the text does not hold N*N tiles in range.
+// Whether every tile appears exactly once is left to IsSolvable.
+int ParseLayout(const char *text, State *a)
+{
+    int p, tiles[NTILES];
+    long tile;
+    char *end;
+
+    for (p=0; p<NTILES; p++)
+    {
+        while (*text == ' ' || *text == ',' || *text == '\t')
+            text++;
+        tile = strtol(text, &end, 10);
+        if (end == text || tile < 0 || tile >= NTILES)
+            return(0);
+        text = end;
+        tiles[p] = (int)tile;
+    }
+    while (*text == ' ' || *text == ',' || *text == '\t' || *text == '\n' || *text == '\r')
+        text++;
+    if (*text != '\0')
+        return(0);
+    *a = PackTiles(tiles);
+    return(1);
+}
+
+// This function packs the tiles of the cells, given in row major order, into a State
+State PackTiles(const int *tiles)
+{
+    int p;
+    State s = 0;
+
+    for (p=0; p<NTILES; p++)
+    {
+        s |= ((State)tiles[p]) << (p*TILEBITS);
+#ifdef BLANKSHIFT
+        if (tiles[p] == BLANK)
+            s |= ((State)p) << BLANKSHIFT;
+#endif
+    }
+    return(s);
+}
+
+// This function returns the parity of the number of inversions among the tiles (the blank
+// left out), plus the row of the blank on boards of even width. A horizontal move changes
+// no inversion, a vertical one moves a tile past N-1 others and the blank by one row, so
+// for either width the parity stays the same whatever moves are made.
+int PermutationParity(State a)
+{
+    int p, q, tile, parity = 0;
+
+    for (p=0; p<NTILES; p++)
+    {
+        tile = GetTile(a, p);
+        if (tile == BLANK)
+            continue;
+        for (q=p+1; q<NTILES; q++)
+            if (GetTile(a, q) != BLANK && GetTile(a, q) < tile)
+                parity ^= 1;
+    }
+    if (N % 2 == 0)
+        parity ^= (GetBlank(a) / N) & 1;
+    return(parity);
+}
+
+// This function determines if the goal can be reached from a: a has to hold every tile
+// exactly once and have the same permutation parity as the goal.
+// returns 1 if the goal can be reached else 0
+int IsSolvable(State goal, State a)
+{
+    int p;
+    uint32_t seen = 0;
+
+    for (p=0; p<NTILES; p++)
+        seen |= 1u << GetTile(a, p);
+    if (seen != (1u << NTILES) - 1)
+        return(0);
+    return(PermutationParity(goal) == PermutationParity(a));
+}
+
+// This function is the entry point of all searches. Start states that can not reach the
+// goal are rejected before any memory is spent on them, otherwise the heuristic lower bound
+// on the solution length is reported and the search is run.
+// returns the path as the searches do, NULL if there is none
+int *Solve(int algorithm, State goal, State start)
+{
+    if (IsSolvable(goal, start) == 0)
+    {
+        if (searchverbose)
+            printf("start state can not reach the goal state\n");
+        return(NULL);
+    }
+
+    ResetMetrics();
+    searchdeadline = searchsettings.timelimit ? NowNanoseconds() + searchsettings.timelimit : 0;
+    BuildHeuristicTables(&htables, goal);
+    if (searchverbose)
+        printf("lower bound on the solution length: %d\n", ComputeHeuristic(&htables, searchsettings.heuristic, goal, start));
+
+    switch (algorithm)
+    {
+    case ALGORITHM_BFS:
+        return(BFS(goal, start));
+    case ALGORITHM_DFS:
+        return(DFS(goal, start));
+    case ALGORITHM_GBEFS:
+        return(GBEFS(goal, start));
+    case ALGORITHM_IDASTAR:
+        return(IDAStar(goal, start));
+    case ALGORITHM_HDASTAR:
+        return(HDAStar(goal, start));
+    case ALGORITHM_PIDASTAR:
+        return(PIDAStar(goal, start));
+    case ALGORITHM_ORACLE:
+        return(OracleSearch(goal, start));
+    case ALGORITHM_BIBFS:
+        return(BidirectionalBFS(goal, start));
+    case ALGORITHM_MM:
+        return(MMSearch(goal, start));
+    case ALGORITHM_SMASTAR:
+        return(SMAStar(goal, start));
+    case ALGORITHM_EXTBFS:
+        return(ExternalBFS(goal, start));
+    case ALGORITHM_ARASTAR:
+        return(ARAStar(goal, start));
+    case ALGORITHM_IDDFS:
+        return(IDDFS(goal, start));
+    }
+    return(AStar(goal, start));
+}
+
+// This function returns the goal configuration of SetGoal
+State DefaultGoal()
+{
+    int i;
+    int **layout;       // unpacked tile configuration used to set up the goal
+    State s;
+
+    // allocate memory to the variable that stores the goal layout.
+    layout = (int **)malloc(sizeof(int *)*N);
+    for (i=0; i<N; i++)
+        layout[i] = (int *)calloc(N, sizeof(int));
+
+    // set the goal state the puzzle
+    SetGoal(layout);
+    s = PackLayout(layout);
+
+    for (i=0; i<N; i++)
+        free(layout[i]);
+    free(layout);
+    return(s);
+}
+
+// This function exchanges the search variables of the calling thread with those of a
+// context. After one call the searches of the thread work with the memory and tables of
+// the context, a second call gives the thread its own variables back.
+void SwapSearchContext(struct SearchContext *c)
+{
+    struct SearchContext saved;
+
+    saved.head = head;
+    saved.arena = arena;
+    saved.htables = htables;
+    saved.frontier = frontier;
+    saved.openlist = openlist;
+    saved.closed = closed;
+    saved.backfrontier = backfrontier;
+    saved.backopenlist = backopenlist;
+    saved.backclosed = backclosed;
+    saved.backtables = backtables;
+    saved.incons = incons;
+    saved.roundclosed = roundclosed;
+    saved.searchstats = searchstats;
+    saved.metrics = metrics;
+    saved.searchdeadline = searchdeadline;
+    saved.searchverbose = searchverbose;
+    saved.searchsettings = searchsettings;
+
+    head = c->head;
+    arena = c->arena;
+    htables = c->htables;
+    frontier = c->frontier;
+    openlist = c->openlist;
+    closed = c->closed;
+    backfrontier = c->backfrontier;
+    backopenlist = c->backopenlist;
+    backclosed = c->backclosed;
+    backtables = c->backtables;
+    incons = c->incons;
+    roundclosed = c->roundclosed;
+    searchstats = c->searchstats;
+    metrics = c->metrics;
+    searchdeadline = c->searchdeadline;
+    searchverbose = c->searchverbose;
+    searchsettings = c->searchsettings;
+
+    *c = saved;
+}
+
+// This function creates a solver of the library interface, with the pattern databases of
+// pdbfile for the goal of SetGoal if it is not NULL
+// returns NULL if the pattern databases can not be loaded or memory runs out
+struct P1Solver *P1CreateSolver(const char *pdbfile)
+{
+    struct P1Solver *solver;
+    struct SearchSettings defaults = DEFAULT_SEARCH_SETTINGS;
+
+    solver = (struct P1Solver *)calloc(1, sizeof(struct P1Solver));
+    if (solver == NULL)
+        return(NULL);
+    solver->context.closed.maxbytes = CLOSED_MAX_BYTES;
+    solver->context.backclosed.maxbytes = CLOSED_MAX_BYTES;
+    solver->context.roundclosed.maxbytes = CLOSED_MAX_BYTES;
+    solver->context.searchsettings = defaults;
+    solver->defaultgoal = DefaultGoal();
+    if (pdbfile != NULL && LoadPatternDatabases(&solver->pdbs, pdbfile, solver->defaultgoal) == 0)
+    {
+        free(solver);
+        return(NULL);
+    }
+    return(solver);
+}
+
+// This function releases a solver and all memory of its searches
+void P1DestroySolver(struct P1Solver *solver)
+{
+    if (solver == NULL)
+        return;
+    SwapSearchContext(&solver->context);
+    FreeSearchMemory();
+    SwapSearchContext(&solver->context);
+    FreePatternDatabases(&solver->pdbs);
+    free(solver->moves);
+    free(solver);
+}
+
+// This function solves one instance with the memory and tables of a solver. The search runs
+// on the calling thread (and the threads of hdastar and pidastar) with the variables of the
+// solver in place of those of the thread, so solvers used on different threads never share
+// anything that a search writes. Nothing is printed, the outcome is in the result.
+struct P1Result P1Solve(struct P1Solver *solver, const int *start, const int *goal, const char *algorithm,
+                        const struct P1Limits *limits)
+{
+    struct P1Result result;
+    struct P1Limits none;
+    State a, g;
+    int i, k, heuristic = HEURISTIC_MANHATTAN;
+    int *path, *moves;
+
+    memset(&result, 0, sizeof(result));
+    memset(&none, 0, sizeof(none));
+    result.status = P1_INVALID;
+    result.length = -1;
+    if (limits == NULL)
+        limits = &none;
+    if (solver == NULL || start == NULL || algorithm == NULL)
+        return(result);
+
+    for (k=0; k<NALGORITHMS; k++)
+        if (strcmp(algorithm, AlgorithmNames[k]) == 0)
+            break;
+    if (limits->heuristic != NULL)
+        for (heuristic=0; heuristic<NSEARCHHEURISTICS; heuristic++)
+            if (strcmp(limits->heuristic, HeuristicNames[heuristic]) == 0)
+                break;
+    for (i=0; i<NTILES; i++)
+        if (start[i] < 0 || start[i] >= NTILES || (goal != NULL && (goal[i] < 0 || goal[i] >= NTILES)))
+            return(result);
+    a = PackTiles(start);
+    g = (goal != NULL) ? PackTiles(goal) : solver->defaultgoal;
+    // every tile exactly once in both, and the tables the algorithm and heuristic need
+    if (k == NALGORITHMS || heuristic == NSEARCHHEURISTICS || (heuristic == HEURISTIC_WALKING && N > 4) ||
+            (heuristic == HEURISTIC_PDB && (solver->pdbs.count == 0 || g != solver->defaultgoal)) ||
+            (k == ALGORITHM_ORACLE && distanceoracle.table == NULL) || !IsSolvable(a, a) || !IsSolvable(g, g))
+        return(result);
+    if (!IsSolvable(g, a))
+    {
+        result.status = P1_UNSOLVABLE;
+        return(result);
+    }
+
+    SwapSearchContext(&solver->context);
+    searchverbose = 0;
+    searchsettings.heuristic = heuristic;
+    searchsettings.threads = limits->threads > 0 ? limits->threads : 1;
+    searchsettings.timelimit = (uint64_t)(limits->seconds*1e9);
+    searchsettings.memorylimit = (size_t)(limits->megabytes*(1<<20));
+    searchsettings.nodebudget = limits->nodes > 0 ? limits->nodes : SMA_NODE_BUDGET;
+    htables.pdbs = (solver->pdbs.count > 0 && g == solver->defaultgoal) ? &solver->pdbs : NULL;
+    memset(&searchstats, 0, sizeof(searchstats));
+
+    path = Solve(k, g, a);
+
+    if (path != NULL && solver->capacity < path[0])
+    {
+        moves = (int *)realloc(solver->moves, sizeof(int)*path[0]);
+        if (moves == NULL)
+        {
+            free(path);
+            path = NULL;
+            searchstats.failed = 1;
+        }
+        else
+        {
+            solver->capacity = path[0];
+            solver->moves = moves;
+        }
+    }
+    if (path != NULL)
+    {
+        // the moves of path are last move first
+        for (i=0; i<path[0]; i++)
+            solver->moves[i] = path[path[0]-i];
+        result.status = P1_SOLVED;
+        result.length = path[0];
+        result.moves = solver->moves;
+    }
+    else
+        result.status = searchstats.failed ? P1_ERROR : searchstats.over_budget ? P1_OVER_BUDGET : P1_NOT_FOUND;
+    result.nodes_expanded = searchstats.nodes_expanded;
+    result.nodes_generated = searchstats.nodes_generated;
+    result.peak_bytes = searchstats.peak_bytes;
+    result.seconds = searchstats.elapsed_ns*1e-9;
+    result.nincumbents = searchstats.nincumbents;
+    free(path);
+    ResetSearchMemory();
+    SwapSearchContext(&solver->context);
+    result.incumbents = solver->context.searchstats.incumbents;
+    return(result);
+}
+
+// This function records the statistics of the search that just ended in searchstats,
+// together with the metrics the thread collected since ResetMetrics
+void ReportSearch(long long expanded, long long generated, int max_depth, long long memory, uint64_t elapsed_ns)
+{
+    int phase;
+
+    searchstats.nodes_expanded = expanded;
+    searchstats.nodes_generated = generated;
+    searchstats.max_depth = max_depth;
+    searchstats.memory_consumed = memory;
+    searchstats.arena_bytes = arena.bytesused;
+    searchstats.duplicates = metrics.duplicates;
+    searchstats.improvements = metrics.improvements;
+    searchstats.reopenings = metrics.reopenings;
+    searchstats.peak_bytes = metrics.peak_bytes + SearchMemoryBytes() - metrics.start_bytes;
+    searchstats.elapsed_ns = elapsed_ns;
+    searchstats.over_budget = metrics.over_budget;
+    searchstats.failed = metrics.failed;
+    for (phase=0; phase<NPHASES; phase++)
+        searchstats.phase_ns[phase] = metrics.phase_ns[phase];
+    searchstats.nincumbents = metrics.nincumbents;
+    memcpy(searchstats.incumbents, metrics.incumbents, sizeof(struct P1Incumbent)*metrics.nincumbents);
+}
+
+// This function performs breadth first search
+int *BFS(State goal, State start)
+{
+/*    start[0][0]=2;
+    start[0][1]=9;
+    start[0][2]=4;
+    start[1][0]=3;
+    start[1][1]=1;
+    start[1][2]=6;
+    start[2][0]=7;
+    start[2][1]=5;
+    start[2][2]=8;
+    
+    start[0][0]=4;
+    start[0][1]=1;
+    start[0][2]=2;
+    start[1][0]=9;
+    start[1][1]=8;
+    start[1][2]=7;
+    start[2][0]=6;
+    start[2][1]=3;
+    start[2][2]=5;
+*/    
+
+    //////////////////////////////////////////////////////////////////// Parameters
+    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+    
+    ////////////////////////////////////////////////////////////////////Computing start time
+    start_time = NowNanoseconds();
+    ////////////////////////////////////////////////////////////////////
+    
+    int i;
+    struct Node *curnode;
+    State child;
+    struct Node *parentnode;
+    int level = -1;
+    int k, from;
+    const struct MoveList *successors;
+    int *path = NULL;
+
+    // create the root node of the search tree
+    curnode = CreateNode(start);
+    ClearClosedTable(&closed);
+    UpdateClosedTable(&closed, start, 0);
+
+    // the root is the first element of the frontier
+    if (curnode != NULL)
+        PushNodeQueue(&frontier, curnode);
+
+    while(frontier.count > 0)
+    {
+        parentnode = PopNodeQueue(&frontier);
+        // the frontier holds at most two levels. When the next one starts, make room
+        // for all of its children at once instead of growing while it is generated
+        if (parentnode->g_val != level)
+        {
+            level = parentnode->g_val;
+            ReserveNodeQueue(&frontier, (frontier.count+1)*(MAXVALIDMOVES-1));
+        }
+
+        /////////////////////////////////////////// Computing parameters
+        nodes_expanded++;            
+        /////////////////////////////////////////////////////////////////        
+        // give up once the time or memory budget is spent
+        if (OverBudget(nodes_expanded))
+            break;
+
+        // check for goal
+        if (GoalTest(goal, parentnode->layout) == 1)
+        {
+            // we have found a goal state!
+            if (searchverbose)
+                printf("goal state found at depth: %d\n", parentnode->g_val);
+            // path[0] - length of the path
+            // path[1:path[0]] - the moves in the path
+            path = (int *)malloc(sizeof(int));
+            path[0] = 0;
+            // traverse the path in the reverse order - from goal to root
+            // while traversing, store the blank tile moves for each step
+            curnode = parentnode;
+            while (curnode->parent != NULL)
+            {
+                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
+                path[path[0]+1] = curnode->move;
+                path[0]++;
+                curnode = curnode->parent;
+            }
+            /////////////////////////////////////////// Printing parameters
+            end_time = NowNanoseconds();
+            ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+            ////////////////////////////////////////////////////////////////////
+
+            return(path);
+        }
+        from = GetBlank(parentnode->layout);
+        successors = &MoveTable[from][parentnode->move+1];
         // compute the children of the current node
-        if (temphead->nodeptr->g_val > MAX_DEPTH){
-            struct SearchQueueElement* temp;
-            temp = temphead;
-            temphead = head;
-            free(temp);
+        PHASE_BEGIN(PHASE_EXPAND);
+        for (k=0; k<successors->count; k++)
+        {
+            i = successors->move[k];
+            child = MoveBlank(parentnode->layout, from, successors->to[k]);
+            // skip configurations already reached at no greater cost
+            if (UpdateClosedTable(&closed, child, parentnode->g_val+1) == 0)
+                continue;
+            /////////////////////////////////////////////////////Computing nodes generated
+            nodes_generated++;
+            /////////////////////////////////////////////////////
+            curnode = CreateNode(child);
+            if (curnode == NULL)
+                break;
+            curnode->move = i;
+            curnode->g_val = parentnode->g_val+1;
+            ////////////////////////////////////////////////////Computing max depth reached
+            if(max_depth < curnode->g_val){
+                max_depth = curnode->g_val;
+            }
+            ////////////////////////////////////////////////////
+            curnode->parent = parentnode;
+            PushNodeQueue(&frontier, curnode);
+        }
+        PHASE_END(PHASE_EXPAND);
+        
+        /////////////////////////////////////////////// Computing Memory consumed
+        if(memory_consumed < nodes_generated-nodes_expanded){
+            memory_consumed = nodes_generated-nodes_expanded;
+        }
+        ///////////////////////////////////////////////
+    }
+    
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+    
+    return(path);
+}
+
+// This function performs Depth first search
+int *DFS(State goal, State start)
+{
+/*    start[0][0]=2;
+    start[0][1]=9;
+    start[0][2]=4;
+    start[1][0]=3;
+    start[1][1]=1;
+    start[1][2]=6;
+    start[2][0]=7;
+    start[2][1]=5;
+    start[2][2]=8;
+    
+    start[0][0]=4;
+    start[0][1]=1;
+    start[0][2]=2;
+    start[1][0]=9;
+    start[1][1]=8;
+    start[1][2]=7;
+    start[2][0]=6;
+    start[2][1]=3;
+    start[2][2]=5;
+*/    
+    //////////////////////////////////////////////////////////////////// Parameters
+    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+    
+    ////////////////////////////////////////////////////////////////////Computing start time
+    start_time = NowNanoseconds();
+    ////////////////////////////////////////////////////////////////////
+
+    int i;
+    struct Node *curnode;
+    State child;
+    struct SearchQueueElement *cursqelement, *temphead;
+    int k, from;
+    const struct MoveList *successors;
+    int *path = NULL;
+
+    // create the root node of the search tree
+    curnode = CreateNode(start);
+    ClearClosedTable(&closed);
+    UpdateClosedTable(&closed, start, 0);
+
+    // create the first element of the search queue
+    if (head == NULL && curnode != NULL)
+    {
+        cursqelement = CreateSearchQueueElement(curnode);
+        head = cursqelement;
+    }
+
+    temphead = head;
+
+    
+
+    while(temphead != NULL)
+    {
+        /////////////////////////////////////////// Computing parameters
+        nodes_expanded++;            
+        /////////////////////////////////////////////////////////////////        
+        // give up once the time or memory budget is spent
+        if (OverBudget(nodes_expanded))
+            break;
+        head = head->next;
+        // check for goal
+        if (GoalTest(goal, temphead->nodeptr->layout) == 1)
+        {
+            // we have found a goal state!
+            if (searchverbose)
+                printf("goal state found at depth: %d\n", temphead->nodeptr->g_val);
+            // path[0] - length of the path
+            // path[1:path[0]] - the moves in the path
+            path = (int *)malloc(sizeof(int));
+            path[0] = 0;
+            // traverse the path in the reverse order - from goal to root
+            // while traversing, store the blank tile moves for each step
+            curnode = temphead->nodeptr;
+            while (curnode->parent != NULL)
+            {
+                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
+                path[path[0]+1] = curnode->move;
+                path[0]++;
+                curnode = curnode->parent;
+            }
+            
+            /////////////////////////////////////////// Printing parameters
+            end_time = NowNanoseconds();
+            ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+            ////////////////////////////////////////////////////////////////////
+
+            return(path);
+        }
+        ExpandClosedEntry(&closed, temphead->nodeptr->layout, temphead->nodeptr->g_val);
+        from = GetBlank(temphead->nodeptr->layout);
+        successors = &MoveTable[from][temphead->nodeptr->move+1];
+        // compute the children of the current node
+        if (temphead->nodeptr->g_val > MAX_DEPTH){
+            temphead = head;
+            continue;
+        }
+        PHASE_BEGIN(PHASE_EXPAND);
+        for (k=0; k<successors->count; k++)
+        {
+            i = successors->move[k];
+            child = MoveBlank(temphead->nodeptr->layout, from, successors->to[k]);
+            // skip configurations already reached at no greater cost
+            if (UpdateClosedTable(&closed, child, temphead->nodeptr->g_val+1) == 0)
+                continue;
+            /////////////////////////////////////////////////////Computing nodes generated
+            nodes_generated++;
+            /////////////////////////////////////////////////////
+            curnode = CreateNode(child);
+            if (curnode == NULL)
+                break;
+            curnode->move = i;
+            curnode->g_val = temphead->nodeptr->g_val+1;
+            ////////////////////////////////////////////////////Computing max depth reached
+            if(max_depth < curnode->g_val){
+                max_depth = curnode->g_val;
+            }
+            ////////////////////////////////////////////////////
+            curnode->parent = temphead->nodeptr;
+            cursqelement = CreateSearchQueueElement(curnode);
+            if (cursqelement == NULL)
+                break;
+            AppendSearchQueueElementToFront(cursqelement);
+        }
+        PHASE_END(PHASE_EXPAND);
+        /////////////////////////////////////////////// Computing Memory consumed
+        if(memory_consumed < nodes_generated-nodes_expanded){
+            memory_consumed = nodes_generated-nodes_expanded;
+        }
+        ///////////////////////////////////////////////
+        temphead = head;
+    }
+            /////////////////////////////////////////// Printing parameters
+            end_time = NowNanoseconds();
+            ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+            ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function performs Greedy best first search
+int *GBEFS(State goal, State start)
+{
+/*    start[0][0]=2;
+    start[0][1]=9;
+    start[0][2]=4;
+    start[1][0]=3;
+    start[1][1]=1;
+    start[1][2]=6;
+    start[2][0]=7;
+    start[2][1]=5;
+    start[2][2]=8;
+    
+    start[0][0]=4;
+    start[0][1]=1;
+    start[0][2]=2;
+    start[1][0]=9;
+    start[1][1]=8;
+    start[1][2]=7;
+    start[2][0]=6;
+    start[2][1]=3;
+    start[2][2]=5;
+*/    
+    
+    //////////////////////////////////////////////////////////////////// Parameters
+    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+    
+    ////////////////////////////////////////////////////////////////////Computing start time
+    start_time = NowNanoseconds();
+    ////////////////////////////////////////////////////////////////////
+        
+    int i;
+    struct Node *curnode;
+    State child;
+    struct Node *parentnode;
+    int k, from;
+    const struct MoveList *successors;
+    int *path = NULL;
+
+    // create the root node of the search tree
+    BuildHeuristicTables(&htables, goal);
+    curnode = CreateNode(start);
+    ClearClosedTable(&closed);
+    UpdateClosedTable(&closed, start, 0);
+
+    // the root is the first element of the open list
+    if (curnode != NULL)
+    {
+        curnode->h_val = HeuristicMisplacedTiles(goal, start);
+        PushOpenList(&openlist, curnode, curnode->h_val);
+    }
+
+    while(openlist.size > 0)
+    {   
+        //////////////////////////////////////////////////////////
+        nodes_expanded++;
+        //////////////////////////////////////////////////////////
+        // give up once the time or memory budget is spent
+        if (OverBudget(nodes_expanded))
+            break;
+        
+        parentnode = PopOpenList(&openlist);
+        // check for goal
+        if (GoalTest(goal, parentnode->layout) == 1)
+        {
+            // we have found a goal state!
+            if (searchverbose)
+                printf("goal state found at depth: %d\n", parentnode->g_val);
+            // path[0] - length of the path
+            // path[1:path[0]] - the moves in the path
+            path = (int *)malloc(sizeof(int));
+            path[0] = 0;
+            // traverse the path in the reverse order - from goal to root
+            // while traversing, store the blank tile moves for each step
+            curnode = parentnode;
+            while (curnode->parent != NULL)
+            {
+                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
+                path[path[0]+1] = curnode->move;
+                path[0]++;
+                curnode = curnode->parent;
+            }
+
+            /////////////////////////////////////////// Printing parameters
+            end_time = NowNanoseconds();
+            ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+            ////////////////////////////////////////////////////////////////////
+
+            return(path);
+        }
+        ExpandClosedEntry(&closed, parentnode->layout, parentnode->g_val);
+        from = GetBlank(parentnode->layout);
+        successors = &MoveTable[from][parentnode->move+1];
+        // compute the children of the current node
+        if (parentnode->g_val > MAX_DEPTH){
+            continue;
+        }
+        PHASE_BEGIN(PHASE_EXPAND);
+        for (k=0; k<successors->count; k++)
+        {
+            i = successors->move[k];
+            child = MoveBlank(parentnode->layout, from, successors->to[k]);
+            // skip configurations already reached at no greater cost
+            if (UpdateClosedTable(&closed, child, parentnode->g_val+1) == 0)
+                continue;
+            ///////////////////////////////////////////////////////////
+            nodes_generated++;
+            ///////////////////////////////////////////////////////////
+            curnode = CreateNode(child);
+            if (curnode == NULL)
+                break;
+            curnode->move = i;
+            curnode->g_val = parentnode->g_val+1;
+            ////////////////////////////////////////////////////Computing max depth reached
+            if(max_depth < curnode->g_val){
+                max_depth = curnode->g_val;
+            }
+            ////////////////////////////////////////////////////
+            curnode->h_val = UpdateHeuristic(&htables, HEURISTIC_MISPLACED, parentnode->layout, child, parentnode->h_val);
+            curnode->parent = parentnode;
+            PushOpenList(&openlist, curnode, curnode->h_val);
+        }
+        PHASE_END(PHASE_EXPAND);
+        /////////////////////////////////////////////// Computing Memory consumed
+        if(memory_consumed < nodes_generated-nodes_expanded){
+            memory_consumed = nodes_generated-nodes_expanded;
+        }
+        ///////////////////////////////////////////////
+    }
+            /////////////////////////////////////////// Printing parameters
+            end_time = NowNanoseconds();
+            ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+            ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function performs A* search ordered on f = g + h. Configurations reached again
+// at a lower cost are reopened, the path is optimal for an admissible heuristic.
+int *AStar(State goal, State start)
+{
+/*    start[0][0]=2;
+    start[0][1]=9;
+    start[0][2]=4;
+    start[1][0]=3;
+    start[1][1]=1;
+    start[1][2]=6;
+    start[2][0]=7;
+    start[2][1]=5;
+    start[2][2]=8;
+    
+    start[0][0]=4;
+    start[0][1]=1;
+    start[0][2]=2;
+    start[1][0]=9;
+    start[1][1]=8;
+    start[1][2]=7;
+    start[2][0]=6;
+    start[2][1]=3;
+    start[2][2]=5;
+*/
+    //////////////////////////////////////////////////////////////////// Parameters
+    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+    
+    ////////////////////////////////////////////////////////////////////Computing start time
+    start_time = NowNanoseconds();
+    ////////////////////////////////////////////////////////////////////
+
+    int i;
+    struct Node *curnode;
+    State child;
+    struct Node *parentnode;
+    int k, from;
+    const struct MoveList *successors;
+    int *path = NULL;
+
+    // create the root node of the search tree
+    BuildHeuristicTables(&htables, goal);
+    curnode = CreateNode(start);
+    ClearClosedTable(&closed);
+    UpdateClosedTable(&closed, start, 0);
+
+    // the root is the first element of the open list
+    if (curnode != NULL)
+    {
+        curnode->h_val = ComputeHeuristic(&htables, searchsettings.heuristic, goal, start);
+        curnode->f_val = curnode->g_val + curnode->h_val;
+        PushOpenList(&openlist, curnode, curnode->f_val);
+    }
+
+    while(openlist.size > 0)
+    {
+        parentnode = PopOpenList(&openlist);
+        // skip stale copies of states that were reopened with a lower cost
+        if (parentnode->g_val > ExpandClosedEntry(&closed, parentnode->layout, parentnode->g_val))
+            continue;
+
+        ///////////////////////////////////////////////////////////////////////////////
+        nodes_expanded++;
+        ///////////////////////////////////////////////////////////////////////////////
+        // give up once the time or memory budget is spent
+        if (OverBudget(nodes_expanded))
+            break;
+        
+        // check for goal
+        if (GoalTest(goal, parentnode->layout) == 1)
+        {
+            // we have found a goal state!
+            if (searchverbose)
+                printf("goal state found at depth: %d\n", parentnode->g_val);
+            // path[0] - length of the path
+            // path[1:path[0]] - the moves in the path
+            path = (int *)malloc(sizeof(int));
+            path[0] = 0;
+            // traverse the path in the reverse order - from goal to root
+            // while traversing, store the blank tile moves for each step
+            curnode = parentnode;
+            while (curnode->parent != NULL)
+            {
+                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
+                path[path[0]+1] = curnode->move;
+                path[0]++;
+                curnode = curnode->parent;
+            }
+            /////////////////////////////////////////// Printing parameters
+            end_time = NowNanoseconds();
+            ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+            ////////////////////////////////////////////////////////////////////
+            return(path);
+        }
+        from = GetBlank(parentnode->layout);
+        successors = &MoveTable[from][parentnode->move+1];
+        // compute the children of the current node
+        PHASE_BEGIN(PHASE_EXPAND);
+        for (k=0; k<successors->count; k++)
+        {
+            i = successors->move[k];
+            child = MoveBlank(parentnode->layout, from, successors->to[k]);
+            // skip configurations already reached at no greater cost
+            if (UpdateClosedTable(&closed, child, parentnode->g_val+1) == 0)
+                continue;
+            ///////////////////////////////////////////////////////////////
+            nodes_generated++;
+            ///////////////////////////////////////////////////////////////
+            curnode = CreateNode(child);
+            if (curnode == NULL)
+                break;
+            curnode->move = i;
+            curnode->g_val = parentnode->g_val+1;
+            ////////////////////////////////////////////////////Computing max depth reached
+            if(max_depth < curnode->g_val){
+                max_depth = curnode->g_val;
+            }
+            ////////////////////////////////////////////////////
+            curnode->h_val = UpdateHeuristic(&htables, searchsettings.heuristic, parentnode->layout, child, parentnode->h_val);
+            curnode->f_val = curnode->g_val + curnode->h_val;
+            curnode->parent = parentnode;
+            PushOpenList(&openlist, curnode, curnode->f_val);
+        }
+        PHASE_END(PHASE_EXPAND);
+        /////////////////////////////////////////////// Computing Memory consumed
+        if(memory_consumed < nodes_generated-nodes_expanded){
+            memory_consumed = nodes_generated-nodes_expanded;
+        }
+        ///////////////////////////////////////////////
+    }
+            /////////////////////////////////////////// Printing parameters
+            end_time = NowNanoseconds();
+            ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+            ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function runs one depth first sweep of IDA* below the current board.
+// The board is changed in place and restored on the way back, the moves of the
+// current path are kept in ida->moves. returns 1 when the goal has been reached
+int IDAStarSweep(struct IDAStarSearch *ida, int g, int h, int lastmove)
+{
+    int i, k, from, ch;
+    State parent, child;
+    const struct MoveList *successors;
+
+    if (ida->stopped)
+        return(0);
+    ida->nodes_expanded++;
+    if (g > ida->max_depth)
+        ida->max_depth = g;
+    // give up once the budget is spent, and in parallel IDA* once a unit before this one has a solution
+    if ((ida->nodes_expanded & (PIDA_POLL_INTERVAL-1)) == 0 && (OverBudget(ida->nodes_expanded) ||
+            (ida->found != NULL && atomic_load_explicit(ida->found, memory_order_relaxed) < ida->unit)))
+    {
+        ida->stopped = 1;
+        return(0);
+    }
+    if (GoalTest(ida->goal, ida->board) == 1)
+    {
+        ida->depth = g;
+        return(1);
+    }
+
+    parent = ida->board;
+    from = GetBlank(parent);
+    successors = &MoveTable[from][lastmove+1];
+    for (k=0; k<successors->count; k++)
+    {
+        i = successors->move[k];
+        ida->nodes_generated++;
+        child = MoveBlank(parent, from, successors->to[k]);
+        ch = UpdateHeuristic(&htables, searchsettings.heuristic, parent, child, h);
+        // children beyond the bound are not visited, they only lower the next bound
+        if (g+1+ch > ida->bound)
+        {
+            if (g+1+ch < ida->nextbound)
+                ida->nextbound = g+1+ch;
+            continue;
+        }
+        ida->moves[g] = i;
+        ida->board = child;
+        if (IDAStarSweep(ida, g+1, ch, i) == 1)
+            return(1);
+        ida->board = parent;
+    }
+    return(0);
+}
+
+// This function performs IDA* search. Each iteration is a depth first sweep bounded
+// by f = g + h (Manhattan distance or pattern databases), the next bound is the smallest f that exceeded the
+// current one. Only the current path is stored, memory is proportional to its depth.
+int *IDAStar(State goal, State start)
+{
+/*    start[0][0]=2;
+    start[0][1]=9;
+    start[0][2]=4;
+    start[1][0]=3;
+    start[1][1]=1;
+    start[1][2]=6;
+    start[2][0]=7;
+    start[2][1]=5;
+    start[2][2]=8;
+    
+    start[0][0]=4;
+    start[0][1]=1;
+    start[0][2]=2;
+    start[1][0]=9;
+    start[1][1]=8;
+    start[1][2]=7;
+    start[2][0]=6;
+    start[2][1]=3;
+    start[2][2]=5;
+*/
+    //////////////////////////////////////////////////////////////////// Parameters
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+    
+    ////////////////////////////////////////////////////////////////////Computing start time
+    start_time = NowNanoseconds();
+    ////////////////////////////////////////////////////////////////////
+
+    int i, h;
+    int *path = NULL;
+    struct IDAStarSearch ida;
+
+    BuildHeuristicTables(&htables, goal);
+    ida.goal = goal;
+    ida.nodes_expanded = 0;
+    ida.nodes_generated = 1;
+    ida.max_depth = 0;
+    ida.found = NULL;
+    ida.stopped = 0;
+    h = ComputeHeuristic(&htables, searchsettings.heuristic, goal, start);
+    ida.bound = h;
+
+    while (ida.bound <= MAX_SOLUTION_LENGTH)
+    {
+        ida.nextbound = INT_MAX;
+        ida.board = start;
+        if (IDAStarSweep(&ida, 0, h, -1) == 1)
+        {
+            // we have found a goal state!
+            if (searchverbose)
+                printf("goal state found at depth: %d\n", ida.depth);
+            // path[0] - length of the path
+            // path[1:path[0]] - the moves in the path, the last move first
+            path = (int *)malloc(sizeof(int)*(ida.depth+1));
+            path[0] = ida.depth;
+            for (i=0; i<ida.depth; i++)
+                path[ida.depth-i] = ida.moves[i];
+            break;
+        }
+        // nothing exceeded the bound, the whole reachable space has been searched
+        if (ida.nextbound == INT_MAX || ida.stopped)
+            break;
+        ida.bound = ida.nextbound;
+    }
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(ida.nodes_expanded, ida.nodes_generated, ida.max_depth, ida.max_depth+1, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function looks up a configuration in the transposition cache of iterative deepening
+// returns 1 if a sweep that already failed from it went at least remaining moves deep
+int ProbeTranspositions(const struct IDDFSSearch *x, State s, int lastmove, int remaining)
+{
+    const struct TranspositionEntry *bucket = &x->cache[2*((HashState(s) + lastmove + 1) & x->mask)];
+
+    return((bucket[0].layout == s && bucket[0].lastmove == lastmove && bucket[0].remaining >= remaining) ||
+           (bucket[1].layout == s && bucket[1].lastmove == lastmove && bucket[1].remaining >= remaining));
+}
+
+// This function records that no goal is within remaining moves of a configuration. It
+// takes the entry of the bucket that already holds the configuration, else the one that
+// failed the shallower sweep, so that the entries that save the most work stay
+void StoreTransposition(struct IDDFSSearch *x, State s, int lastmove, int remaining)
+{
+    struct TranspositionEntry *entry = &x->cache[2*((HashState(s) + lastmove + 1) & x->mask)];
+
+    if ((entry[1].layout == s && entry[1].lastmove == lastmove) ||
+            (!(entry[0].layout == s && entry[0].lastmove == lastmove) && entry[1].remaining < entry[0].remaining))
+        entry++;
+    if (entry->layout == s && entry->lastmove == lastmove && entry->remaining >= remaining)
+        return;
+    entry->layout = s;
+    entry->lastmove = lastmove;
+    entry->remaining = remaining;
+}
+
+// This function runs one depth limited sweep of iterative deepening below the current
+// board. The board is changed in place and restored on the way back, the moves of the
+// current path are kept in x->moves. returns 1 when the goal has been reached
+int IDDFSSweep(struct IDDFSSearch *x, int g, int lastmove)
+{
+    int i, k, from;
+    State parent;
+    const struct MoveList *successors;
+
+    x->nodes_expanded++;
+    if (g > x->max_depth)
+        x->max_depth = g;
+    // give up once the time or memory budget is spent
+    if (OverBudget(x->nodes_expanded))
+    {
+        x->stopped = 1;
+        return(0);
+    }
+    if (GoalTest(x->goal, x->board) == 1)
+    {
+        x->depth = g;
+        return(1);
+    }
+    if (g == x->limit)
+        return(0);
+    // a configuration that was searched at least as deep before is not searched again,
+    // whichever path led to it then. Close to the limit a sweep is cheaper than a probe.
+    if (x->limit - g >= IDDFS_CACHE_MIN_DEPTH && ProbeTranspositions(x, x->board, lastmove, x->limit - g))
+    {
+        metrics.duplicates++;
+        return(0);
+    }
+
+    parent = x->board;
+    from = GetBlank(parent);
+    successors = &MoveTable[from][lastmove+1];
+    for (k=0; k<successors->count; k++)
+    {
+        i = successors->move[k];
+        x->nodes_generated++;
+        x->moves[g] = i;
+        x->board = MoveBlank(parent, from, successors->to[k]);
+        if (IDDFSSweep(x, g+1, i) == 1)
+            return(1);
+        if (x->stopped)
+            return(0);
+    }
+    x->board = parent;
+    if (x->limit - g >= IDDFS_CACHE_MIN_DEPTH)
+        StoreTransposition(x, parent, lastmove, x->limit - g);
+    return(0);
+}
+
+// This function performs iterative deepening depth first search. Each iteration is a depth
+// first sweep one move deeper than the one before, so the first solution found is a shortest
+// one while only the current path is stored. A bounded cache of configurations that failed
+// a sweep cuts off the subtrees below transpositions, -cache sets its number of entries.
+int *IDDFS(State goal, State start)
+{
+    //////////////////////////////////////////////////////////////////// Parameters
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+
+    start_time = NowNanoseconds();
+
+    int i;
+    int *path = NULL;
+    struct IDDFSSearch x;
+    size_t buckets;
+
+    // a power of 2 buckets of two entries
+    for (buckets = 1; 4*buckets <= (size_t)searchsettings.cacheentries; buckets *= 2)
+        ;
+    x.cache = (struct TranspositionEntry *)calloc(2*buckets, sizeof(struct TranspositionEntry));
+    x.mask = buckets-1;
+    x.goal = goal;
+    x.nodes_expanded = 0;
+    x.nodes_generated = 1;
+    x.max_depth = 0;
+    x.stopped = 0;
+    if (x.cache == NULL)
+    {
+        FailSearch("out of memory for the transposition cache");
+        x.stopped = 1;
+    }
+
+    for (x.limit = 0; x.limit <= MAX_SOLUTION_LENGTH && !x.stopped; x.limit++)
+    {
+        x.board = start;
+        if (IDDFSSweep(&x, 0, -1) == 1)
+        {
+            // we have found a goal state!
+            if (searchverbose)
+                printf("goal state found at depth: %d\n", x.depth);
+            // path[0] - length of the path
+            // path[1:path[0]] - the moves in the path, the last move first
+            path = (int *)malloc(sizeof(int)*(x.depth+1));
+            if (path == NULL)
+            {
+                FailSearch("out of memory for the path");
+                break;
+            }
+            path[0] = x.depth;
+            for (i=0; i<x.depth; i++)
+                path[x.depth-i] = x.moves[i];
+            break;
+        }
+    }
+    if (x.cache != NULL)
+        metrics.peak_bytes += 2*buckets*sizeof(struct TranspositionEntry);
+    free(x.cache);
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(x.nodes_expanded, x.nodes_generated, x.max_depth, x.max_depth+1, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function appends a message to an inbox. Any thread may call it
+void PushHDAInbox(struct HDAInbox *q, struct HDAMessage *m)
+{
+    struct HDAMessage *prev;
+
+    atomic_store_explicit(&m->next, NULL, memory_order_relaxed);
+    prev = atomic_exchange_explicit(&q->tail, m, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, m, memory_order_release);
+}
+
+// This function removes the oldest message of an inbox. Only the owner of the inbox may call it.
+// returns NULL if the inbox is empty or the next message is still being appended
+struct HDAMessage *PopHDAInbox(struct HDAInbox *q)
+{
+    struct HDAMessage *head = q->head;
+    struct HDAMessage *next = atomic_load_explicit(&head->next, memory_order_acquire);
+
+    if (head == &q->stub)
+    {
+        if (next == NULL)
+            return(NULL);
+        q->head = next;
+        head = next;
+        next = atomic_load_explicit(&head->next, memory_order_acquire);
+    }
+    if (next != NULL)
+    {
+        q->head = next;
+        return(head);
+    }
+    // head is the last message, put the stub behind it before handing it out
+    if (head != atomic_load_explicit(&q->tail, memory_order_acquire))
+        return(NULL);
+    PushHDAInbox(q, &q->stub);
+    next = atomic_load_explicit(&head->next, memory_order_acquire);
+    if (next != NULL)
+    {
+        q->head = next;
+        return(head);
+    }
+    return(NULL);
+}
+
+// This function returns the thread of HDA* that owns a configuration. The high half of the
+// hash is used, the low bits already pick the slot in the closed table of that thread
+int HDAOwner(const struct HDAStarSearch *hda, State s)
+{
+    return((int)((HashState(s) >> 32) % (uint64_t)hda->nworkers));
+}
+
+// This function hands a child to the thread that owns it
+void SendHDAMessage(struct HDAStarSearch *hda, State layout, int g, float h, int move, struct Node *parent)
+{
+    struct HDAMessage *m;
+
+    m = (struct HDAMessage *)ArenaAlloc(&arena, sizeof(struct HDAMessage));
+    if (m == NULL)
+    {
+        FailSearch("out of memory for the nodes of the search");
+        return;
+    }
+    m->layout = layout;
+    m->g_val = g;
+    m->h_val = h;
+    m->move = move;
+    m->parent = parent;
+    atomic_fetch_add(&hda->inflight, 1);
+    PushHDAInbox(&hda->workers[HDAOwner(hda, layout)].inbox, m);
+}
+
+// This function puts a child owned by the calling thread on its open list unless the
+// configuration has been reached at no greater cost already
+void OpenHDANode(struct HDAWorker *self, State layout, int g, float h, int move, struct Node *parent)
+{
+    struct Node *curnode;
+
+    if (UpdateClosedTable(&closed, layout, g) == 0)
+        return;
+    self->nodes_generated++;
+    if (self->max_depth < g)
+        self->max_depth = g;
+    curnode = CreateNode(layout);
+    if (curnode == NULL)
+        return;
+    curnode->g_val = g;
+    curnode->h_val = h;
+    curnode->f_val = g + h;
+    curnode->move = move;
+    curnode->parent = parent;
+    PushOpenList(&openlist, curnode, curnode->f_val);
+    if (self->memory_consumed < openlist.size)
+        self->memory_consumed = openlist.size;
+}
+
+// This function is the body of every HDA* thread. It alternates between receiving the
+// children sent to it and expanding its best node. Nodes whose f is not below the cost of
+// the best solution found are dropped; once every thread is out of nodes and no message
+// is under way, no node with a smaller f is left anywhere and the best solution is optimal.
+void *HDAStarWorker(void *arg)
+{
+    struct HDAWorker *self = (struct HDAWorker *)arg;
+    struct HDAStarSearch *hda = self->search;
+    struct HDAMessage *m;
+    struct Node *parentnode, *curnode;
+    int k, from;
+    const struct MoveList *successors;
+    State child;
+    int i, idle = 0, best, owner;
+    long epoch;
+    float h;
+
+    // the search only starts once all threads run, none of them can be left waiting at the barrier
+    while (atomic_load(&hda->go) == 0)
+        sched_yield();
+    if (atomic_load(&hda->go) < 0)
+        return(NULL);
+    htables.pdbs = hda->pdbs;
+    BuildHeuristicTables(&htables, hda->goal);
+    ResetMetrics();
+    searchdeadline = hda->deadline;
+    searchsettings = hda->settings;
+    ClearClosedTable(&closed);
+    openlist.size = 0;
+
+    while (atomic_load(&hda->done) == 0)
+    {
+        // receive the children sent by the other threads
+        while ((m = PopHDAInbox(&self->inbox)) != NULL)
+        {
+            if (idle)
+            {
+                // announce the work before the message stops counting as under way
+                idle = 0;
+                atomic_fetch_add(&hda->epoch, 1);
+                atomic_fetch_sub(&hda->idle, 1);
+            }
+            if (m->g_val + m->h_val < atomic_load(&hda->best))
+                OpenHDANode(self, m->layout, m->g_val, m->h_val, m->move, m->parent);
+            atomic_fetch_sub(&hda->inflight, 1);
+        }
+
+        // expand the best node that can still lead to a better solution
+        parentnode = NULL;
+        while (openlist.size > 0)
+        {
+            parentnode = PopOpenList(&openlist);
+            if (parentnode->f_val >= atomic_load(&hda->best))
+            {
+                // the rest of the open list is no better
+                openlist.size = 0;
+                parentnode = NULL;
+            }
+            else if (parentnode->g_val > ExpandClosedEntry(&closed, parentnode->layout, parentnode->g_val))
+                parentnode = NULL;
+            else
+                break;
+        }
+
+        if (parentnode == NULL)
+        {
+            if (idle == 0)
+            {
+                idle = 1;
+                atomic_fetch_add(&hda->idle, 1);
+            }
+            // everybody idle and nothing under way, with no thread woken up in between
+            epoch = atomic_load(&hda->epoch);
+            if (atomic_load(&hda->idle) == hda->nworkers && atomic_load(&hda->inflight) == 0 && atomic_load(&hda->epoch) == epoch)
+                atomic_store(&hda->done, 1);
+            else
+                sched_yield();
+            continue;
+        }
+
+        self->nodes_expanded++;
+        if (OverBudget(self->nodes_expanded))
+        {
+            atomic_store(&hda->done, 1);
+            break;
+        }
+        if (GoalTest(hda->goal, parentnode->layout) == 1)
+        {
+            pthread_mutex_lock(&hda->lock);
+            if (parentnode->g_val < atomic_load(&hda->best))
+            {
+                atomic_store(&hda->best, parentnode->g_val);
+                hda->goalnode = parentnode;
+            }
+            pthread_mutex_unlock(&hda->lock);
+            continue;
+        }
+        // f >= best prunes every other path that can not improve the solution
+        if (parentnode->g_val >= MAX_SOLUTION_LENGTH)
+            continue;
+
+        from = GetBlank(parentnode->layout);
+        successors = &MoveTable[from][parentnode->move+1];
+        best = atomic_load(&hda->best);
+        PHASE_BEGIN(PHASE_EXPAND);
+        for (k=0; k<successors->count; k++)
+        {
+            i = successors->move[k];
+            child = MoveBlank(parentnode->layout, from, successors->to[k]);
+            h = UpdateHeuristic(&htables, searchsettings.heuristic, parentnode->layout, child, parentnode->h_val);
+            if (parentnode->g_val+1 + h >= best)
+                continue;
+            owner = HDAOwner(hda, child);
+            if (owner == self->index)
+                OpenHDANode(self, child, parentnode->g_val+1, h, i, parentnode);
+            else
+                SendHDAMessage(hda, child, parentnode->g_val+1, h, i, parentnode);
+        }
+        PHASE_END(PHASE_EXPAND);
+    }
+
+    // the nodes of a solution are spread over the arenas of all threads,
+    // keep them until the path has been read back
+    pthread_barrier_wait(&hda->barrier);
+    if (self->index == 0 && hda->goalnode != NULL)
+    {
+        // path[0] - length of the path
+        // path[1:path[0]] - the moves in the path
+        hda->path = (int *)malloc(sizeof(int)*(hda->goalnode->g_val+1));
+        if (hda->path == NULL)
+            FailSearch("out of memory for the path");
+        else
+        {
+            hda->path[0] = 0;
+            for (curnode=hda->goalnode; curnode->parent != NULL; curnode=curnode->parent)
+                hda->path[++hda->path[0]] = curnode->move;
+        }
+    }
+    pthread_barrier_wait(&hda->barrier);
+    self->metrics = metrics;
+    self->metrics.peak_bytes += SearchMemoryBytes() - metrics.start_bytes;
+    FreeSearchMemory();
+    return(NULL);
+}
+
+// This function performs hash distributed A* search (HDA*) with searchsettings.threads threads.
+// Every configuration belongs to one thread, chosen by its hash, which keeps the open
+// list and closed table for it. Children are sent to their owner through lock free
+// inboxes, so the threads only ever share the messages and the cost of the best solution.
+// f is g+h, the search returns an optimal path for an admissible heuristic.
+int *HDAStar(State goal, State start)
+{
+    //////////////////////////////////////////////////////////////////// Parameters
+    long long nodes_expanded=0,nodes_generated=1,memory_consumed=0;
+    int max_depth=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////Computing start time
+    start_time = NowNanoseconds();
+    ////////////////////////////////////////////////////////////////////
+
+    int i, started;
+    struct HDAStarSearch hda;
+    struct HDAWorker *worker;
+
+    hda.goal = goal;
+    hda.pdbs = htables.pdbs;
+    hda.nworkers = searchsettings.threads > 0 ? searchsettings.threads : 1;
+    hda.workers = (struct HDAWorker *)aligned_alloc(64, sizeof(struct HDAWorker)*hda.nworkers);
+    if (hda.workers == NULL)
+    {
+        FailSearch("out of memory for the threads of HDA*");
+        ReportSearch(0, 1, 0, 0, NowNanoseconds() - start_time);
+        return(NULL);
+    }
+    memset(hda.workers, 0, sizeof(struct HDAWorker)*hda.nworkers);
+    atomic_init(&hda.best, INT_MAX);
+    hda.goalnode = NULL;
+    pthread_mutex_init(&hda.lock, NULL);
+    atomic_init(&hda.inflight, 0);
+    atomic_init(&hda.idle, 0);
+    atomic_init(&hda.epoch, 0);
+    atomic_init(&hda.done, 0);
+    atomic_init(&hda.go, 0);
+    hda.deadline = searchdeadline;
+    hda.settings = searchsettings;
+    pthread_barrier_init(&hda.barrier, NULL, hda.nworkers);
+    hda.path = NULL;
+    for (i=0; i<hda.nworkers; i++)
+    {
+        worker = &hda.workers[i];
+        worker->search = &hda;
+        worker->index = i;
+        atomic_init(&worker->inbox.stub.next, NULL);
+        atomic_init(&worker->inbox.tail, &worker->inbox.stub);
+        worker->inbox.head = &worker->inbox.stub;
+    }
+
+    // the root goes to its owner like any other child
+    BuildHeuristicTables(&htables, goal);
+    SendHDAMessage(&hda, start, 0, ComputeHeuristic(&htables, searchsettings.heuristic, goal, start), -1, NULL);
+
+    for (started=0; started<hda.nworkers; started++)
+        if (pthread_create(&hda.workers[started].thread, NULL, HDAStarWorker, &hda.workers[started]) != 0)
+            break;
+    atomic_store(&hda.go, started == hda.nworkers ? 1 : -1);
+    if (started < hda.nworkers)
+        FailSearch("could not start the threads of HDA*");
+    for (i=0; i<started; i++)
+    {
+        pthread_join(hda.workers[i].thread, NULL);
+        nodes_expanded += hda.workers[i].nodes_expanded;
+        nodes_generated += hda.workers[i].nodes_generated;
+        memory_consumed += hda.workers[i].memory_consumed;
+        if (max_depth < hda.workers[i].max_depth)
+            max_depth = hda.workers[i].max_depth;
+        AddMetrics(&metrics, &hda.workers[i].metrics);
+    }
+    if (metrics.over_budget)
+    {
+        // a solution found before giving up need not be optimal
+        free(hda.path);
+        hda.path = NULL;
+    }
+    if (hda.path != NULL && searchverbose)
+        printf("goal state found at depth: %d\n", hda.path[0]);
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+
+    pthread_barrier_destroy(&hda.barrier);
+    pthread_mutex_destroy(&hda.lock);
+    free(hda.workers);
+    return(hda.path);
+}
+
+// This function cuts the tree one level deeper: every work unit of parallel IDA* is replaced
+// by its children whose f is within the bound, in the same order, so the units stay in
+// depth first order. Goals are kept as they are. Every unit is expanded once, the nodes
+// above the final cut count as expanded once per iteration as in IDAStar.
+// returns 0 and fails the search if memory runs out
+int SplitPIDAStar(struct PIDAStarSearch *p)
+{
+    int u, i, k, from, ch, n = 0, capacity = p->nunits*MAXVALIDMOVES;
+    State child;
+    const struct MoveList *successors;
+    struct PIDAUnit *unit, *next;
+
+    if (p->sparecapacity < capacity)
+    {
+        next = (struct PIDAUnit *)realloc(p->spare, sizeof(struct PIDAUnit)*capacity);
+        if (next == NULL)
+        {
+            FailSearch("out of memory for the work units of parallel IDA*");
+            return(0);
+        }
+        p->spare = next;
+        p->sparecapacity = capacity;
+    }
+
+    for (u=0; u<p->nunits; u++)
+    {
+        unit = &p->units[u];
+        if (unit->board == p->goal)
+        {
+            p->spare[n++] = *unit;
+            continue;
+        }
+        p->nodes_expanded++;
+        from = GetBlank(unit->board);
+        successors = &MoveTable[from][unit->lastmove+1];
+        for (k=0; k<successors->count; k++)
+        {
+            i = successors->move[k];
+            p->nodes_generated++;
+            child = MoveBlank(unit->board, from, successors->to[k]);
+            ch = UpdateHeuristic(&htables, searchsettings.heuristic, unit->board, child, unit->h);
+            if (unit->g+1+ch > p->bound)
+            {
+                if (unit->g+1+ch < atomic_load(&p->nextbound))
+                    atomic_store(&p->nextbound, unit->g+1+ch);
+                continue;
+            }
+            next = &p->spare[n++];
+            next->board = child;
+            next->g = unit->g+1;
+            next->h = ch;
+            next->lastmove = i;
+            memcpy(next->moves, unit->moves, unit->g);
+            next->moves[unit->g] = i;
+        }
+    }
+
+    // the new level becomes the frontier, the old one is the spare of the next split
+    next = p->units;
+    p->units = p->spare;
+    p->spare = next;
+    capacity = p->unitcapacity;
+    p->unitcapacity = p->sparecapacity;
+    p->sparecapacity = capacity;
+    p->nunits = n;
+    return(1);
+}
+
+// This function hands out the next work unit to a thread, from its own deque if it has
+// any left, else stolen from the back of another thread's deque.
+// returns the index of the unit, -1 once all units are taken
+int TakePIDAUnit(struct PIDAStarSearch *p, int index)
+{
+    int i, unit = -1;
+    struct PIDADeque *q = &p->deques[index];
+
+    pthread_mutex_lock(&q->lock);
+    if (q->front < q->back)
+        unit = q->front++;
+    pthread_mutex_unlock(&q->lock);
+
+    for (i=1; unit < 0 && i<p->nworkers; i++)
+    {
+        q = &p->deques[(index+i) % p->nworkers];
+        pthread_mutex_lock(&q->lock);
+        if (q->front < q->back)
+            unit = --q->back;
+        pthread_mutex_unlock(&q->lock);
+    }
+    return(unit);
+}
+
+// This function is the body of every thread of parallel IDA*. Each unit is swept as in
+// IDAStar with the moves of the frontier in front of the path. Units after one that has
+// a solution are skipped or abandoned, units before it are finished, so the solution kept
+// is the first one in depth first order, the same that IDAStar finds.
+void *PIDAStarWorker(void *arg)
+{
+    struct PIDAWorker *self = (struct PIDAWorker *)arg;
+    struct PIDAStarSearch *p = self->search;
+    struct PIDAUnit *unit;
+    struct IDAStarSearch ida;
+    int u, k;
+
+    htables.pdbs = p->pdbs;
+    BuildHeuristicTables(&htables, p->goal);
+    ResetMetrics();
+    searchdeadline = p->deadline;
+    searchsettings = p->settings;
+    ida.goal = p->goal;
+    ida.bound = p->bound;
+    ida.found = &p->found;
+    ida.nodes_expanded = 0;
+    ida.nodes_generated = 0;
+    ida.max_depth = 0;
+
+    while ((u = TakePIDAUnit(p, self->index)) >= 0)
+    {
+        if (u > atomic_load(&p->found))
+            continue;
+        unit = &p->units[u];
+        ida.unit = u;
+        ida.stopped = 0;
+        ida.nextbound = INT_MAX;
+        ida.board = unit->board;
+        for (k=0; k<unit->g; k++)
+            ida.moves[k] = unit->moves[k];
+
+        if (IDAStarSweep(&ida, unit->g, unit->h, unit->lastmove) == 1)
+        {
+            pthread_mutex_lock(&p->lock);
+            if (u < atomic_load(&p->found))
+            {
+                atomic_store(&p->found, u);
+                p->depth = ida.depth;
+                memcpy(p->moves, ida.moves, sizeof(int)*ida.depth);
+            }
+            pthread_mutex_unlock(&p->lock);
+        }
+        else if (ida.stopped == 0)
+        {
+            // only complete sweeps know the next bound
+            u = atomic_load(&p->nextbound);
+            while (ida.nextbound < u && !atomic_compare_exchange_weak(&p->nextbound, &u, ida.nextbound))
+                ;
+        }
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->nodes_expanded += ida.nodes_expanded;
+    p->nodes_generated += ida.nodes_generated;
+    if (p->max_depth < ida.max_depth)
+        p->max_depth = ida.max_depth;
+    AddMetrics(&p->metrics, &metrics);
+    pthread_mutex_unlock(&p->lock);
+    return(NULL);
+}
+
+// This function performs IDA* with searchsettings.threads threads. Every iteration the tree is cut
+// at the shallowest depth that gives PIDA_UNITS_PER_THREAD units per thread, found by splitting
+// the units one level at a time from the root. Each thread starts with a contiguous share of
+// the units and steals from the others once it runs out.
+int *PIDAStar(State goal, State start)
+{
+    //////////////////////////////////////////////////////////////////// Parameters
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+
+    ////////////////////////////////////////////////////////////////////Computing start time
+    start_time = NowNanoseconds();
+    ////////////////////////////////////////////////////////////////////
+
+    int i, h, splitdepth, started;
+    int *path = NULL;
+    struct PIDAStarSearch p;
+    struct PIDAWorker *workers;
+
+    BuildHeuristicTables(&htables, goal);
+    p.goal = goal;
+    p.pdbs = htables.pdbs;
+    p.nworkers = searchsettings.threads > 0 ? searchsettings.threads : 1;
+    p.units = (struct PIDAUnit *)malloc(sizeof(struct PIDAUnit));
+    p.unitcapacity = 1;
+    p.spare = NULL;
+    p.sparecapacity = 0;
+    p.deques = (struct PIDADeque *)aligned_alloc(64, sizeof(struct PIDADeque)*p.nworkers);
+    workers = (struct PIDAWorker *)malloc(sizeof(struct PIDAWorker)*p.nworkers);
+    if (p.units == NULL || p.deques == NULL || workers == NULL)
+    {
+        FailSearch("out of memory for the threads of parallel IDA*");
+        free(p.units);
+        free(p.deques);
+        free(workers);
+        ReportSearch(0, 1, 0, 0, NowNanoseconds() - start_time);
+        return(NULL);
+    }
+    for (i=0; i<p.nworkers; i++)
+    {
+        pthread_mutex_init(&p.deques[i].lock, NULL);
+        workers[i].search = &p;
+        workers[i].index = i;
+    }
+    pthread_mutex_init(&p.lock, NULL);
+    p.nodes_expanded = 0;
+    p.nodes_generated = 1;
+    p.max_depth = 0;
+    memset(&p.metrics, 0, sizeof(p.metrics));
+    p.deadline = searchdeadline;
+    p.settings = searchsettings;
+    h = ComputeHeuristic(&htables, searchsettings.heuristic, goal, start);
+    p.bound = h;
+
+    while (p.bound <= MAX_SOLUTION_LENGTH)
+    {
+        atomic_init(&p.nextbound, INT_MAX);
+        atomic_init(&p.found, INT_MAX);
+        // the root alone is the cut at depth 0
+        p.nunits = 1;
+        p.units[0].board = start;
+        p.units[0].g = 0;
+        p.units[0].h = h;
+        p.units[0].lastmove = -1;
+        for (splitdepth=1; splitdepth<PIDA_MAX_SPLIT_DEPTH && p.nunits < PIDA_UNITS_PER_THREAD*p.nworkers; splitdepth++)
+            if (SplitPIDAStar(&p) == 0)
+                break;
+        if (metrics.failed)
+            break;
+        for (i=0; i<p.nworkers; i++)
+        {
+            p.deques[i].front = (int)((long long)p.nunits*i/p.nworkers);
+            p.deques[i].back = (int)((long long)p.nunits*(i+1)/p.nworkers);
+        }
+
+        for (started=0; started<p.nworkers; started++)
+            if (pthread_create(&workers[started].thread, NULL, PIDAStarWorker, &workers[started]) != 0)
+                break;
+        if (started < p.nworkers)
+        {
+            // the threads that run skip or abandon all units, as after a solution in unit -1
+            atomic_store(&p.found, -1);
+            FailSearch("could not start the threads of parallel IDA*");
+        }
+        for (i=0; i<started; i++)
+            pthread_join(workers[i].thread, NULL);
+        if (started < p.nworkers)
+            break;
+
+        if (atomic_load(&p.found) != INT_MAX)
+        {
+            // we have found a goal state!
+            if (searchverbose)
+                printf("goal state found at depth: %d\n", p.depth);
+            // path[0] - length of the path
+            // path[1:path[0]] - the moves in the path, the last move first
+            path = (int *)malloc(sizeof(int)*(p.depth+1));
+            if (path == NULL)
+            {
+                FailSearch("out of memory for the path");
+                break;
+            }
+            path[0] = p.depth;
+            for (i=0; i<p.depth; i++)
+                path[p.depth-i] = p.moves[i];
+            break;
+        }
+        // nothing exceeded the bound, the whole reachable space has been searched
+        if (atomic_load(&p.nextbound) == INT_MAX || p.metrics.over_budget)
+            break;
+        p.bound = atomic_load(&p.nextbound);
+    }
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    AddMetrics(&metrics, &p.metrics);
+    metrics.peak_bytes += sizeof(struct PIDAUnit)*(p.unitcapacity + p.sparecapacity);
+    ReportSearch(p.nodes_expanded, p.nodes_generated, p.max_depth, p.max_depth+1, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+
+    for (i=0; i<p.nworkers; i++)
+        pthread_mutex_destroy(&p.deques[i].lock);
+    pthread_mutex_destroy(&p.lock);
+    free(p.deques);
+    free(workers);
+    free(p.units);
+    free(p.spare);
+    return(path);
+}
+
+// This function answers a query from the distance oracle. From every configuration it
+// takes the first move to a neighbour one move closer to the goal, so the path is optimal
+// and found without any search; a node is "expanded" for every move of the path.
+int *OracleSearch(State goal, State start)
+{
+    uint64_t start_time,end_time;
+    int i, k, from, d, length = 0;
+    int moves[EIGHT_PUZZLE_MAX_LENGTH];
+    long long nodes_generated = 1;
+    const struct MoveList *successors;
+    State a = start, child = start;
+    int *path = NULL;
+
+    start_time = NowNanoseconds();
+    d = OracleDistance(&distanceoracle, a);
+    while (a != goal && length < EIGHT_PUZZLE_MAX_LENGTH)
+    {
+        from = GetBlank(a);
+        successors = &MoveTable[from][(length > 0 ? moves[length-1] : -1)+1];
+        for (k=0; k<successors->count; k++)
+        {
+            child = MoveBlank(a, from, successors->to[k]);
+            nodes_generated++;
+            if (OracleDistance(&distanceoracle, child) == ((d+15) & 0xF))
+                break;
+        }
+        // only a table that does not belong to the goal has no closer neighbour
+        if (k == successors->count)
+            break;
+        moves[length++] = successors->move[k];
+        d = (d+15) & 0xF;
+        a = child;
+    }
+
+    if (a == goal)
+    {
+        if (searchverbose)
+            printf("goal state found at depth: %d\n", length);
+        // path[0] - length of the path
+        // path[1:path[0]] - the moves in the path, the last move first
+        path = (int *)malloc(sizeof(int)*(length+1));
+        if (path == NULL)
+            FailSearch("out of memory for the path");
+        else
+        {
+            path[0] = length;
+            for (i=0; i<length; i++)
+                path[length-i] = moves[i];
+        }
+    }
+
+    end_time = NowNanoseconds();
+    ReportSearch(length, nodes_generated, length, 0, end_time - start_time);
+    return(path);
+}
+
+// This function follows a closed table down to the root of its search: from every
+// configuration a neighbour recorded with a lower cost is on a path to the root, and the
+// costs in the table are those of real paths, so the walk takes at most as many moves as
+// the cost recorded for s. moves[i] is the i-th move of the walk.
+// returns the number of moves, -1 if the table does not lead to the root
+int DescendClosedTable(struct ClosedTable *t, State s, int *moves)
+{
+    int k, from, d, cd, best, length = 0;
+    State child, next = s;
+    const struct MoveList *successors;
+
+    d = LookupClosedTable(t, s);
+    while (d > 0 && d != INT_MAX)
+    {
+        from = GetBlank(s);
+        successors = &MoveTable[from][0];
+        best = -1;
+        for (k=0; k<successors->count; k++)
+        {
+            child = MoveBlank(s, from, successors->to[k]);
+            cd = LookupClosedTable(t, child);
+            if (cd < d)
+            {
+                d = cd;
+                next = child;
+                best = successors->move[k];
+            }
+        }
+        if (best < 0)
+            return(-1);
+        moves[length++] = best;
+        s = next;
+    }
+    return(d == 0 ? length : -1);
+}
+
+// This function joins the two halves of a bidirectional search where they meet. node is
+// the node of the meeting configuration on the side that found the meeting, its half of
+// the path is read from the parent chain; the other half is found by walking down the
+// closed table of the other side.
+// returns the path as the searches do, NULL if the halves can not be joined or memory runs out
+int *JoinPaths(struct Node *node, int backward, struct ClosedTable *other)
+{
+    int i, n, half, length = 0;
+    int moves[2*MAX_SOLUTION_LENGTH+2], rest[MAX_SOLUTION_LENGTH+1];
+    struct Node *curnode;
+    int *path;
+
+    if (node->g_val > MAX_SOLUTION_LENGTH || LookupClosedTable(other, node->layout) > MAX_SOLUTION_LENGTH)
+        return(NULL);
+    half = DescendClosedTable(other, node->layout, rest);
+    if (half < 0)
+        return(NULL);
+
+    // moves[] is the path from the start to the goal, first move first
+    for (curnode=node; curnode->parent!=NULL; curnode=curnode->parent)
+        length++;
+    if (backward == 0)
+    {
+        // the parent chain leads back to the start, the table on to the goal
+        for (i=length-1, curnode=node; curnode->parent!=NULL; i--, curnode=curnode->parent)
+            moves[i] = curnode->move;
+        for (i=0; i<half; i++)
+            moves[length+i] = rest[i];
+    }
+    else
+    {
+        // the table leads back to the start, the parent chain on to the goal; both are
+        // walked towards their roots, so their moves are undone in reverse order
+        for (i=0; i<half; i++)
+            moves[half-1-i] = rest[i] ^ 1;
+        for (i=half, curnode=node; curnode->parent!=NULL; i++, curnode=curnode->parent)
+            moves[i] = curnode->move ^ 1;
+    }
+    n = length + half;
+
+    // path[0] - length of the path
+    // path[1:path[0]] - the moves in the path, the last move first
+    path = (int *)malloc(sizeof(int)*(n+1));
+    if (path == NULL)
+    {
+        FailSearch("out of memory for the path");
+        return(NULL);
+    }
+    path[0] = n;
+    for (i=0; i<n; i++)
+        path[n-i] = moves[i];
+    return(path);
+}
+
+// This function performs bidirectional breadth first search, one search from the start
+// and one from the goal. It always expands a whole level of the smaller frontier and
+// checks every new configuration against the closed table of the other side; the best
+// meeting of the first level that has one is a shortest path, found at about half the
+// depth of a breadth first search.
+int *BidirectionalBFS(State goal, State start)
+{
+    //////////////////////////////////////////////////////////////////// Parameters
+    int nodes_expanded=0,nodes_generated=2,max_depth=0,memory_consumed=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+
+    start_time = NowNanoseconds();
+
+    int i, k, from, d, side, best = INT_MAX, meetside = 0;
+    size_t n;
+    State child;
+    struct Node *curnode, *parentnode, *root, *meet = NULL;
+    struct NodeQueue *queue;
+    struct ClosedTable *own, *other;
+    const struct MoveList *successors;
+    int *path = NULL;
+
+    // the roots of both searches
+    ClearClosedTable(&closed);
+    ClearClosedTable(&backclosed);
+    UpdateClosedTable(&closed, start, 0);
+    UpdateClosedTable(&backclosed, goal, 0);
+    root = CreateNode(start);
+    curnode = CreateNode(goal);
+    if (root != NULL && curnode != NULL)
+    {
+        PushNodeQueue(&frontier, root);
+        PushNodeQueue(&backfrontier, curnode);
+    }
+    if (start == goal)
+    {
+        best = 0;
+        meet = root;
+    }
+
+    while (best == INT_MAX && frontier.count > 0 && backfrontier.count > 0 && !metrics.over_budget)
+    {
+        side = (backfrontier.count < frontier.count);
+        queue = side ? &backfrontier : &frontier;
+        own = side ? &backclosed : &closed;
+        other = side ? &closed : &backclosed;
+        ReserveNodeQueue(queue, queue->count*(MAXVALIDMOVES-1));
+
+        for (n=queue->count; n>0; n--)
+        {
+            parentnode = PopNodeQueue(queue);
+            nodes_expanded++;
+            // give up once the time or memory budget is spent
+            if (OverBudget(nodes_expanded))
+                break;
+
+            from = GetBlank(parentnode->layout);
+            successors = &MoveTable[from][parentnode->move+1];
+            PHASE_BEGIN(PHASE_EXPAND);
+            for (k=0; k<successors->count; k++)
+            {
+                i = successors->move[k];
+                child = MoveBlank(parentnode->layout, from, successors->to[k]);
+                if (UpdateClosedTable(own, child, parentnode->g_val+1) == 0)
+                    continue;
+                nodes_generated++;
+                curnode = CreateNode(child);
+                if (curnode == NULL)
+                    break;
+                curnode->move = i;
+                curnode->g_val = parentnode->g_val+1;
+                if(max_depth < curnode->g_val){
+                    max_depth = curnode->g_val;
+                }
+                curnode->parent = parentnode;
+                PushNodeQueue(queue, curnode);
+
+                d = LookupClosedTable(other, child);
+                if (d != INT_MAX && curnode->g_val + d < best)
+                {
+                    best = curnode->g_val + d;
+                    meet = curnode;
+                    meetside = side;
+                }
+            }
+            PHASE_END(PHASE_EXPAND);
+        }
+        if(memory_consumed < (int)(frontier.count + backfrontier.count)){
+            memory_consumed = frontier.count + backfrontier.count;
+        }
+    }
+
+    if (meet != NULL && !metrics.over_budget)
+    {
+        path = JoinPaths(meet, meetside, meetside ? &closed : &backclosed);
+        if (path != NULL && searchverbose)
+            printf("goal state found at depth: %d\n", path[0]);
+    }
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function performs MM, bidirectional A* that meets in the middle. Both sides order
+// their open lists on max(f, 2g), so neither expands a node beyond half the solution length,
+// and every new configuration is checked against the closed table of the other side. The
+// search stops once the best meeting costs no more than the smallest priority on either
+// open list, which bounds every path not found yet. The backward search uses the heuristic
+// to the start; the pattern databases only hold for the goal, so it falls back to Manhattan
+// distance when they are chosen.
+int *MMSearch(State goal, State start)
+{
+    //////////////////////////////////////////////////////////////////// Parameters
+    int nodes_expanded=0,nodes_generated=2,max_depth=0,memory_consumed=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+
+    start_time = NowNanoseconds();
+
+    int i, k, from, d, side, h, best = INT_MAX, meetside = 0;
+    int backheuristic = (searchsettings.heuristic == HEURISTIC_PDB) ? HEURISTIC_MANHATTAN : searchsettings.heuristic;
+    float bound;
+    State child;
+    struct Node *curnode, *parentnode, *root, *meet = NULL;
+    struct OpenList *open;
+    struct ClosedTable *own, *other;
+    const struct HeuristicTables *tables;
+    const struct MoveList *successors;
+    int *path = NULL;
+
+    BuildHeuristicTables(&htables, goal);
+    BuildHeuristicTables(&backtables, start);
+    backtables.pdbs = NULL;
+
+    // the roots of both searches
+    ClearClosedTable(&closed);
+    ClearClosedTable(&backclosed);
+    UpdateClosedTable(&closed, start, 0);
+    UpdateClosedTable(&backclosed, goal, 0);
+    root = CreateNode(start);
+    curnode = CreateNode(goal);
+    if (root != NULL && curnode != NULL)
+    {
+        root->h_val = ComputeHeuristic(&htables, searchsettings.heuristic, goal, start);
+        PushOpenList(&openlist, root, root->h_val);
+        curnode->h_val = ComputeHeuristic(&backtables, backheuristic, start, goal);
+        PushOpenList(&backopenlist, curnode, curnode->h_val);
+    }
+    if (start == goal)
+    {
+        best = 0;
+        meet = root;
+    }
+
+    while (openlist.size > 0 && backopenlist.size > 0)
+    {
+        // expand on the side with the lower priority, stop once nothing can beat the best meeting
+        side = (backopenlist.elements[0].key < openlist.elements[0].key);
+        open = side ? &backopenlist : &openlist;
+        bound = open->elements[0].key;
+        if (best <= bound)
+            break;
+        own = side ? &backclosed : &closed;
+        other = side ? &closed : &backclosed;
+        tables = side ? &backtables : &htables;
+        h = side ? backheuristic : searchsettings.heuristic;
+
+        parentnode = PopOpenList(open);
+        // skip stale copies of states that were reopened with a lower cost
+        if (parentnode->g_val > ExpandClosedEntry(own, parentnode->layout, parentnode->g_val))
+            continue;
+        nodes_expanded++;
+        // give up once the time or memory budget is spent
+        if (OverBudget(nodes_expanded))
+            break;
+
+        from = GetBlank(parentnode->layout);
+        successors = &MoveTable[from][parentnode->move+1];
+        PHASE_BEGIN(PHASE_EXPAND);
+        for (k=0; k<successors->count; k++)
+        {
+            i = successors->move[k];
+            child = MoveBlank(parentnode->layout, from, successors->to[k]);
+            if (UpdateClosedTable(own, child, parentnode->g_val+1) == 0)
+                continue;
+            nodes_generated++;
+            curnode = CreateNode(child);
+            if (curnode == NULL)
+                break;
+            curnode->move = i;
+            curnode->g_val = parentnode->g_val+1;
+            if(max_depth < curnode->g_val){
+                max_depth = curnode->g_val;
+            }
+            curnode->h_val = UpdateHeuristic(tables, h, parentnode->layout, child, parentnode->h_val);
+            curnode->f_val = curnode->g_val + curnode->h_val;
+            if (curnode->f_val < 2*curnode->g_val)
+                curnode->f_val = 2*curnode->g_val;
+            curnode->parent = parentnode;
+            PushOpenList(open, curnode, curnode->f_val);
+
+            d = LookupClosedTable(other, child);
+            if (d != INT_MAX && curnode->g_val + d < best)
+            {
+                best = curnode->g_val + d;
+                meet = curnode;
+                meetside = side;
+            }
+        }
+        PHASE_END(PHASE_EXPAND);
+        if(memory_consumed < openlist.size + backopenlist.size){
+            memory_consumed = openlist.size + backopenlist.size;
+        }
+    }
+
+    if (meet != NULL && !metrics.over_budget)
+    {
+        path = JoinPaths(meet, meetside, meetside ? &closed : &backclosed);
+        if (path != NULL && searchverbose)
+            printf("goal state found at depth: %d\n", path[0]);
+    }
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function returns 1 if heap entry a comes before entry b
+int SMAHeapBefore(const struct SMAHeap *heap, const struct SMAHeapEntry *a, const struct SMAHeapEntry *b)
+{
+    if (heap->worst)
+        return(a->key > b->key || (a->key == b->key && a->g_val < b->g_val));
+    return(a->key < b->key || (a->key == b->key && a->g_val > b->g_val));
+}
+
+// This function adds a node to an SMA* heap with the given key
+void PushSMAHeap(struct SMAHeap *heap, struct SMANode *node, int key)
+{
+    int i, parent, capacity;
+    struct SMAHeapEntry entry, *entries;
+
+    if (heap->size == heap->capacity)
+    {
+        capacity = heap->capacity ? 2*heap->capacity : 1024;
+        entries = (struct SMAHeapEntry *)realloc(heap->entries, sizeof(struct SMAHeapEntry)*capacity);
+        if (entries == NULL)
+        {
+            // the search has failed and stops, the entry is dropped
+            FailSearch("out of memory for the heaps of SMA*");
+            return;
+        }
+        heap->entries = entries;
+        heap->capacity = capacity;
+    }
+    entry.key = key;
+    entry.g_val = node->g_val;
+    entry.stamp = node->stamp;
+    entry.node = node;
+
+    i = heap->size++;
+    while (i > 0)
+    {
+        parent = (i-1)/2;
+        if (!SMAHeapBefore(heap, &entry, &heap->entries[parent]))
+            break;
+        heap->entries[i] = heap->entries[parent];
+        i = parent;
+    }
+    heap->entries[i] = entry;
+}
+
+// This function removes the first entry of an SMA* heap
+struct SMAHeapEntry PopSMAHeap(struct SMAHeap *heap)
+{
+    int i = 0, child;
+    struct SMAHeapEntry top = heap->entries[0], last = heap->entries[--heap->size];
+
+    while ((child = 2*i+1) < heap->size)
+    {
+        if (child+1 < heap->size && SMAHeapBefore(heap, &heap->entries[child+1], &heap->entries[child]))
+            child++;
+        if (!SMAHeapBefore(heap, &heap->entries[child], &last))
+            break;
+        heap->entries[i] = heap->entries[child];
+        i = child;
+    }
+    heap->entries[i] = last;
+    return(top);
+}
+
+// This function puts a node that changed into the heaps it belongs in: the open heap while
+// it has children to generate, keyed on its own f as a leaf or on the lowest f of its dropped
+// children, and the heap of leaves while it has no children in memory
+void QueueSMANode(struct SMAStarSearch *s, struct SMANode *node)
+{
+    int key = node->children ? node->forgotten : node->f_val;
+
+    node->stamp++;
+    if (key != INT_MAX)
+        PushSMAHeap(&s->open, node, key);
+    if (node->children == 0)
+        PushSMAHeap(&s->leaves, node, node->f_val);
+}
+
+// This function rebuilds both heaps from the nodes in memory once stale entries make up most
+// of them, so the heaps stay within a fixed multiple of the node budget
+void CompactSMAHeaps(struct SMAStarSearch *s)
+{
+    int i;
+
+    s->open.size = 0;
+    s->leaves.size = 0;
+    for (i=0; i<s->next; i++)
+        if (s->pool[i].inuse)
+            QueueSMANode(s, &s->pool[i]);
+}
+
+// This function drops the worst leaf from memory: the highest f, the shallowest of those.
+// Its f is backed up to its parent, which has to generate it again before anything with a
+// higher f is expanded. The root and keep, the node being expanded, are never dropped.
+// returns 0 if there is no leaf to drop
+int DropSMALeaf(struct SMAStarSearch *s, struct SMANode *keep)
+{
+    struct SMAHeapEntry e;
+    struct SMANode *node, *parent;
+
+    while (s->leaves.size > 0)
+    {
+        e = PopSMAHeap(&s->leaves);
+        node = e.node;
+        if (!node->inuse || node->stamp != e.stamp || node->children != 0 || node == keep || node->parent == NULL)
+            continue;
+
+        parent = node->parent;
+        parent->children &= ~(1 << node->move);
+        if (node->f_val < parent->forgotten)
+            parent->forgotten = node->f_val;
+        // the node being expanded keeps its f for the rest of its children and is
+        // queued once it is done
+        if (parent != keep)
+        {
+            if (parent->children == 0)
+                parent->f_val = parent->forgotten;
+            QueueSMANode(s, parent);
+        }
+
+        node->inuse = 0;
+        node->stamp++;
+        node->parent = s->free;
+        s->free = node;
+        s->used--;
+        s->nodes_dropped++;
+        return(1);
+    }
+    return(0);
+}
+
+// This function takes a node from the pool: a dropped one, else the next one never used,
+// else it drops a leaf. The pool is only touched as far as the search gets into it
+// returns NULL if no node can be freed
+struct SMANode *NewSMANode(struct SMAStarSearch *s, struct SMANode *keep)
+{
+    struct SMANode *node;
+
+    if (s->free == NULL && s->next < s->budget)
+    {
+        node = &s->pool[s->next++];
+        node->stamp = 0;
+    }
+    else
+    {
+        if (s->free == NULL && DropSMALeaf(s, keep) == 0)
+            return(NULL);
+        node = s->free;
+        s->free = node->parent;
+    }
+    s->used++;
+    node->inuse = 1;
+    node->children = 0;
+    node->forgotten = INT_MAX;
+    return(node);
+}
+
+// This function performs SMA*, A* within a fixed budget of nodes. The nodes are taken from
+// a pool of the budget; when it is used up the worst leaf is dropped and its f backed up to
+// its parent, whose f then tells when the dropped part of the tree is worth generating again.
+// A path of more nodes than the budget can not be kept, so nodes with an f beyond it count
+// as dead ends.
+// The solution is optimal whenever its path fits in the budget, otherwise the search gives
+// up and reports that it ran over budget.
+int *SMAStar(State goal, State start)
+{
+    //////////////////////////////////////////////////////////////////// Parameters
+    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+
+    start_time = NowNanoseconds();
+
+    int i, k, from, g, h, f;
+    State child;
+    struct SMAStarSearch s;
+    struct SMAHeapEntry e;
+    struct SMANode *node, *curnode;
+    const struct MoveList *successors;
+    int *path = NULL;
+
+    memset(&s, 0, sizeof(s));
+    s.budget = searchsettings.nodebudget > 1 ? searchsettings.nodebudget : 2;
+    s.pool = (struct SMANode *)malloc(sizeof(struct SMANode)*s.budget);
+    s.leaves.worst = 1;
+
+    BuildHeuristicTables(&htables, goal);
+    if (s.pool == NULL)
+        FailSearch("out of memory for the nodes of SMA*");
+    else
+    {
+        node = NewSMANode(&s, NULL);
+        node->layout = start;
+        node->g_val = 0;
+        node->h_val = ComputeHeuristic(&htables, searchsettings.heuristic, goal, start);
+        node->f_val = node->h_val;
+        node->move = -1;
+        node->parent = NULL;
+        if (node->f_val <= s.budget-1)
+            QueueSMANode(&s, node);
+    }
+
+    while (s.open.size > 0)
+    {
+        e = PopSMAHeap(&s.open);
+        node = e.node;
+        if (!node->inuse || node->stamp != e.stamp)
+            continue;
+
+        ///////////////////////////////////////////////////////////////////////////////
+        nodes_expanded++;
+        ///////////////////////////////////////////////////////////////////////////////
+        // give up once the time or memory budget is spent
+        if (OverBudget(nodes_expanded))
+            break;
+
+        // check for goal
+        if (GoalTest(goal, node->layout) == 1)
+        {
+            if (searchverbose)
+                printf("goal state found at depth: %d\n", node->g_val);
+            // path[0] - length of the path
+            // path[1:path[0]] - the moves in the path, the last move first
+            path = (int *)malloc(sizeof(int)*(node->g_val+1));
+            if (path == NULL)
+            {
+                FailSearch("out of memory for the path");
+                break;
+            }
+            path[0] = node->g_val;
+            for (i=1, curnode=node; curnode->parent!=NULL; i++, curnode=curnode->parent)
+                path[i] = curnode->move;
+            break;
+        }
+
+        // generate the children that are not in memory, the node leaves the heaps meanwhile
+        node->stamp++;
+        node->forgotten = INT_MAX;
+        from = GetBlank(node->layout);
+        successors = &MoveTable[from][node->move+1];
+        PHASE_BEGIN(PHASE_EXPAND);
+        for (k=0; k<successors->count; k++)
+        {
+            i = successors->move[k];
+            if (node->children & (1 << i))
+                continue;
+            child = MoveBlank(node->layout, from, successors->to[k]);
+            g = node->g_val+1;
+            h = UpdateHeuristic(&htables, searchsettings.heuristic, node->layout, child, node->h_val);
+            // f never falls below the f of the parent
+            f = (g+h > node->f_val) ? g+h : node->f_val;
+            // a solution through the child has at least f+1 nodes on its path, more
+            // than the budget can hold
+            if (f > s.budget-1)
+                continue;
+            curnode = NewSMANode(&s, node);
+            if (curnode == NULL)
+            {
+                // no room for the child, its f is backed up as for a dropped leaf so
+                // that the node is expanded again once the child is worth generating
+                if (f < node->forgotten)
+                    node->forgotten = f;
+                continue;
+            }
+            nodes_generated++;
+            curnode->layout = child;
+            curnode->g_val = g;
+            curnode->h_val = h;
+            curnode->f_val = f;
+            curnode->move = i;
+            curnode->parent = node;
+            node->children |= 1 << i;
+            QueueSMANode(&s, curnode);
+            if(max_depth < g){
+                max_depth = g;
+            }
+        }
+        PHASE_END(PHASE_EXPAND);
+        if (node->children == 0)
+            node->f_val = node->forgotten;
+        QueueSMANode(&s, node);
+
+        if(memory_consumed < s.used){
+            memory_consumed = s.used;
+        }
+        if (s.open.size + s.leaves.size > SMA_HEAP_SLACK*s.budget)
+            CompactSMAHeaps(&s);
+    }
+
+    // only a path longer than the budget can leave no node to expand
+    if (path == NULL && !metrics.over_budget)
+    {
+        metrics.over_budget = 1;
+        if (searchverbose)
+            printf("no solution fits in the budget of %d nodes\n", s.budget);
+    }
+    if (searchverbose)
+        printf("nodes dropped from memory: %lld\n", s.nodes_dropped);
+
+    metrics.peak_bytes += s.next*sizeof(struct SMANode) +
+                          (s.open.capacity + s.leaves.capacity)*sizeof(struct SMAHeapEntry);
+    free(s.pool);
+    free(s.open.entries);
+    free(s.leaves.entries);
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function names the file of a layer, or of a run of the layer being generated
+void SpillFileName(const struct ExternalBFS *x, const char *kind, int number, char *name)
+{
+    snprintf(name, SPILL_NAME_LENGTH, "%s-%s%d", x->prefix, kind, number);
+}
+
+// This function records that a file of external memory BFS could not be read or written.
+// The search fails; the program says why, the library leaves it to the status of the result
+void SpillError(const char *name)
+{
+    metrics.failed = 1;
+#ifdef P1_LIBRARY
+    (void)name;
+#else
+    perror(name);
+#endif
+}
+
+// This function orders two states for qsort and the merge of the runs
+int CompareStates(const void *x, const void *y)
+{
+    State a = *(const State *)x, b = *(const State *)y;
+
+    return((a > b) - (a < b));
+}
+
+// This function opens a file of sorted states for reading and reads its first state
+// returns 0 if the file can not be opened
+int OpenStateStream(struct StateStream *s, const char *name)
+{
+    s->fp = fopen(name, "rb");
+    if (s->fp == NULL)
+    {
+        s->valid = 0;
+        return(0);
+    }
+    setvbuf(s->fp, NULL, _IOFBF, EXT_IO_BUFFER);
+    s->valid = (fread(&s->cur, sizeof(State), 1, s->fp) == 1);
+    return(1);
+}
+
+// This function moves a stream on to its next state
+void NextState(struct StateStream *s)
+{
+    s->valid = (fread(&s->cur, sizeof(State), 1, s->fp) == 1);
+}
+
+void CloseStateStream(struct StateStream *s)
+{
+    if (s->fp != NULL)
+        fclose(s->fp);
+    s->fp = NULL;
+    s->valid = 0;
+}
+
+// This function sorts the buffered successors, removes the duplicates among them and
+// writes them out as the next run of the layer
+// returns 0 on a write error
+int WriteRun(struct ExternalBFS *x)
+{
+    size_t i, n = 0;
+    char name[SPILL_NAME_LENGTH];
+    FILE *fp;
+    int written;
+
+    if (x->runsize == 0)
+        return(1);
+    qsort(x->run, x->runsize, sizeof(State), CompareStates);
+    for (i=0; i<x->runsize; i++)
+        if (n == 0 || x->run[i] != x->run[n-1])
+            x->run[n++] = x->run[i];
+
+    // a run that is not written completely is still counted, its file is removed with the others
+    SpillFileName(x, "run", x->nruns++, name);
+    fp = fopen(name, "wb");
+    written = (fp != NULL && fwrite(x->run, sizeof(State), n, fp) == n);
+    if (fp != NULL && fclose(fp) != 0)
+        written = 0;
+    if (!written)
+    {
+        SpillError(name);
+        return(0);
+    }
+    x->bytes_written += n*sizeof(State);
+    x->runsize = 0;
+    return(1);
+}
+
+// This function merges the runs of a layer into the file of the layer. A configuration
+// that is in one of the two layers before it was reached earlier and is left out: the
+// neighbours of layer d are all in layer d-1 or d+1, so no other layer can hold it. All
+// files are read front to back at the same time.
+// returns the number of states in the layer, -1 on an I/O error
+long long MergeRuns(struct ExternalBFS *x, int layer, State goal, int *found)
+{
+    int i, nstreams, child, top;
+    long long count = 0;
+    char name[SPILL_NAME_LENGTH];
+    struct StateStream *runs, previous, before;
+    int *heap;
+    State s, last = 0;
+    FILE *fp;
+
+    runs = (struct StateStream *)calloc(x->nruns+1, sizeof(struct StateStream));
+    heap = (int *)malloc(sizeof(int)*(x->nruns+1));
+    if (runs == NULL || heap == NULL)
+    {
+        FailSearch("out of memory for merging the runs of a layer");
+        for (i=0; i<x->nruns; i++)
+        {
+            SpillFileName(x, "run", i, name);
+            unlink(name);
+        }
+        x->nruns = 0;
+        free(runs);
+        free(heap);
+        return(-1);
+    }
+    nstreams = 0;
+    for (i=0; i<x->nruns; i++)
+    {
+        SpillFileName(x, "run", i, name);
+        if (OpenStateStream(&runs[i], name) == 0)
+        {
+            SpillError(name);
+            count = -1;
+        }
+        if (runs[i].valid)
+        {
+            // sift the run up the min-heap of the fronts of the runs
+            for (child=nstreams++; child > 0 && CompareStates(&runs[heap[(child-1)/2]].cur, &runs[i].cur) > 0; child=(child-1)/2)
+                heap[child] = heap[(child-1)/2];
+            heap[child] = i;
+        }
+    }
+    SpillFileName(x, "layer", layer-1, name);
+    OpenStateStream(&previous, name);
+    SpillFileName(x, "layer", layer-2, name);
+    OpenStateStream(&before, name);
+    SpillFileName(x, "layer", layer, name);
+    fp = fopen(name, "wb");
+    if (fp == NULL)
+    {
+        SpillError(name);
+        count = -1;
+    }
+    else
+        setvbuf(fp, NULL, _IOFBF, EXT_IO_BUFFER);
+
+    while (count >= 0 && nstreams > 0)
+    {
+        top = heap[0];
+        s = runs[top].cur;
+        NextState(&runs[top]);
+        if (!runs[top].valid)
+            top = heap[--nstreams];
+        // sift the run that was at the top down to its place
+        for (i=0; (child = 2*i+1) < nstreams; i=child)
+        {
+            if (child+1 < nstreams && CompareStates(&runs[heap[child+1]].cur, &runs[heap[child]].cur) < 0)
+                child++;
+            if (CompareStates(&runs[heap[child]].cur, &runs[top].cur) >= 0)
+                break;
+            heap[i] = heap[child];
+        }
+        if (nstreams > 0)
+            heap[i] = top;
+
+        if (count > 0 && s == last)
+            continue;
+        while (previous.valid && previous.cur < s)
+            NextState(&previous);
+        while (before.valid && before.cur < s)
+            NextState(&before);
+        if ((previous.valid && previous.cur == s) || (before.valid && before.cur == s))
+            continue;
+        if (fwrite(&s, sizeof(State), 1, fp) != 1)
+        {
+            SpillError(name);
+            count = -1;
+            break;
+        }
+        if (s == goal)
+            *found = 1;
+        last = s;
+        count++;
+    }
+    if (fp != NULL && fclose(fp) != 0)
+    {
+        SpillError(name);
+        count = -1;
+    }
+    if (count > 0)
+        x->bytes_written += count*sizeof(State);
+    else if (count < 0)
+        unlink(name);   // the layer is incomplete, the search ends with the layer before it
+
+    CloseStateStream(&previous);
+    CloseStateStream(&before);
+    for (i=0; i<x->nruns; i++)
+    {
+        CloseStateStream(&runs[i]);
+        SpillFileName(x, "run", i, name);
+        unlink(name);
+    }
+    x->nruns = 0;
+    free(runs);
+    free(heap);
+    return(count);
+}
+
+// This function generates layer d+1 from the file of layer d, the successors go through
+// the buffer into sorted runs which are then merged
+// returns the size of the new layer, -1 on an I/O error or when the budget is spent
+long long ExpandLayer(struct ExternalBFS *x, int layer, State goal, int *found)
+{
+    int k, from;
+    char name[SPILL_NAME_LENGTH];
+    struct StateStream current;
+    const struct MoveList *successors;
+
+    SpillFileName(x, "layer", layer, name);
+    if (OpenStateStream(&current, name) == 0)
+    {
+        SpillError(name);
+        return(-1);
+    }
+    for (; current.valid; NextState(&current))
+    {
+        x->nodes_expanded++;
+        if (OverBudget(x->nodes_expanded))
+            break;
+        if (x->runsize + MAXVALIDMOVES > x->runcapacity && WriteRun(x) == 0)
+            break;
+        from = GetBlank(current.cur);
+        successors = &MoveTable[from][0];
+        for (k=0; k<successors->count; k++)
+            x->run[x->runsize++] = MoveBlank(current.cur, from, successors->to[k]);
+        x->nodes_generated += successors->count;
+    }
+    CloseStateStream(&current);
+    if (current.valid || WriteRun(x) == 0)
+    {
+        // the layer was not read to its end, throw away its runs
+        x->runsize = 0;
+        for (k=0; k<x->nruns; k++)
+        {
+            SpillFileName(x, "run", k, name);
+            unlink(name);
+        }
+        x->nruns = 0;
+        return(-1);
+    }
+    return(MergeRuns(x, layer+1, goal, found));
+}
+
+// This function sets up an external memory search whose files go to the directory of
+// -spill, with a buffer of the size of -memlimit
+// returns 0 and fails the search if the buffer can not be had, else 1
+int StartExternalBFS(struct ExternalBFS *x)
+{
+    static atomic_int searches;
+    size_t bytes = searchsettings.memorylimit ? searchsettings.memorylimit : EXT_RUN_BYTES;
+    const char *directory = searchsettings.spilldirectory;
+
+    if (directory == NULL && (directory = getenv("TMPDIR")) == NULL)
+        directory = "/tmp";
+    memset(x, 0, sizeof(*x));
+    // searches of different processes and threads must not share files
+    snprintf(x->prefix, sizeof(x->prefix), "%s/p1-%d-%d", directory, (int)getpid(), atomic_fetch_add(&searches, 1));
+    x->runcapacity = bytes/sizeof(State) > 4*MAXVALIDMOVES ? bytes/sizeof(State) : 4*MAXVALIDMOVES;
+    x->run = (State *)malloc(sizeof(State)*x->runcapacity);
+    if (x->run == NULL)
+    {
+        FailSearch("out of memory for the runs of external memory BFS");
+        x->runcapacity = 0;
+        return(0);
+    }
+    return(1);
+}
+
+// This function removes the files of layers first to last, the runs not yet merged and
+// the buffer of the search
+void EndExternalBFS(struct ExternalBFS *x, int first, int last)
+{
+    int d;
+    char name[SPILL_NAME_LENGTH];
+
+    for (d=first; d<=last; d++)
+    {
+        SpillFileName(x, "layer", d, name);
+        unlink(name);
+    }
+    for (d=0; d<x->nruns; d++)
+    {
+        SpillFileName(x, "run", d, name);
+        unlink(name);
+    }
+    x->nruns = 0;
+    free(x->run);
+    x->run = NULL;
+}
+
+// This function writes the file of layer 0, the start state alone
+// returns 0 on a write error
+int WriteFirstLayer(struct ExternalBFS *x, State start)
+{
+    x->run[0] = start;
+    x->runsize = 1;
+    if (WriteRun(x) == 0)
+        return(0);
+    return(MergeRuns(x, 0, start, &(int){0}) == 1);
+}
+
+// This function finds the path from the start to a configuration of layer depth. It walks
+// back one layer at a time, reading each layer file once front to back for a neighbour
+// of the configuration it has reached. path[i] is filled for i = 1..depth, the last move first
+// returns 0 if a layer file can not be read
+int TraceLayers(struct ExternalBFS *x, int depth, State s, int *path)
+{
+    int d, k, from, found;
+    char name[SPILL_NAME_LENGTH];
+    struct StateStream layer;
+    const struct MoveList *successors;
+
+    for (d=depth-1; d>=0; d--)
+    {
+        SpillFileName(x, "layer", d, name);
+        if (OpenStateStream(&layer, name) == 0)
+        {
+            SpillError(name);
+            return(0);
+        }
+        for (found = 0; layer.valid && !found; NextState(&layer))
+        {
+            from = GetBlank(layer.cur);
+            successors = &MoveTable[from][0];
+            for (k=0; k<successors->count && !found; k++)
+                if (MoveBlank(layer.cur, from, successors->to[k]) == s)
+                {
+                    path[depth-d] = successors->move[k];
+                    found = 1;
+                    s = layer.cur;
+                }
+        }
+        CloseStateStream(&layer);
+        if (!found)
+            return(0);
+    }
+    return(1);
+}
+
+// This function performs breadth first search in external memory. Every layer is written
+// to disk as a sorted file and generated from the file of the layer before it, so only the
+// buffer of one run has to fit in memory and all reads and writes are sequential. The
+// layers are kept until the goal is found, the path is then traced back through them.
+int *ExternalBFS(State goal, State start)
+{
+    //////////////////////////////////////////////////////////////////// Parameters
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+
+    start_time = NowNanoseconds();
+
+    int depth = 0, found = (start == goal);
+    long long size = 1, largest = 1;
+    struct ExternalBFS x;
+    int *path = NULL;
+
+    if (StartExternalBFS(&x) == 0 || WriteFirstLayer(&x, start) == 0)
+        size = -1;
+    while (size > 0 && !found)
+    {
+        size = ExpandLayer(&x, depth, goal, &found);
+        if (size < 0)
+            break;
+        depth++;
+        if (largest < size)
+            largest = size;
+        if (searchverbose)
+            printf("layer %d: %lld states, %lld bytes written\n", depth, size, x.bytes_written);
+    }
+
+    if (found)
+    {
+        if (searchverbose)
+            printf("goal state found at depth: %d\n", depth);
+        // path[0] - length of the path
+        // path[1:path[0]] - the moves in the path, the last move first
+        path = (int *)malloc(sizeof(int)*(depth+1));
+        if (path == NULL)
+            FailSearch("out of memory for the path");
+        else
+        {
+            path[0] = depth;
+            if (TraceLayers(&x, depth, goal, path) == 0)
+            {
+                free(path);
+                path = NULL;
+            }
+        }
+    }
+    EndExternalBFS(&x, 0, depth);
+    metrics.peak_bytes += x.runcapacity*sizeof(State);
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(x.nodes_expanded, x.nodes_generated, depth, largest, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+    return(path);
+}
+
+// This function explores the configurations reachable from start layer by layer in external
+// memory, up to maxdepth moves or until there are no new ones, and prints the size of
+// every layer. Only the last two layers are kept on disk.
+// returns 0 on success, 1 on an I/O error
+int ExploreLayers(State start, int maxdepth)
+{
+    int depth = 0, found = 0;
+    long long size = 1, total = 1;
+    uint64_t start_time = NowNanoseconds();
+    char name[SPILL_NAME_LENGTH];
+    struct ExternalBFS x;
+
+    if (StartExternalBFS(&x) == 0 || WriteFirstLayer(&x, start) == 0)
+        size = -1;
+    else
+        printf("layer 0: 1 states\n");
+    while (size > 0 && depth < maxdepth)
+    {
+        // no state of the start layer has a neighbour in the start layer, it can
+        // never be found again as a new layer and only serves to mark layers as seen
+        size = ExpandLayer(&x, depth, start, &found);
+        if (size < 0)
+            break;
+        depth++;
+        total += size;
+        printf("layer %d: %lld states, %lld in total, %lld bytes written, %.3f s\n", depth, size, total,
+               x.bytes_written, (NowNanoseconds() - start_time)*1e-9);
+        fflush(stdout);
+        // layer d-2 is not needed for the layers after d
+        if (depth >= 2)
+        {
+            SpillFileName(&x, "layer", depth-2, name);
+            unlink(name);
+        }
+    }
+    EndExternalBFS(&x, depth >= 1 ? depth-1 : 0, depth);
+    return(size < 0 ? 1 : 0);
+}
+
+// This function returns the path to a node of the search tree, NULL if memory runs out
+// path[0] - length of the path
+// path[1:path[0]] - the moves in the path, the last move first
+int *TracePath(struct Node *curnode)
+{
+    int *path = (int *)malloc(sizeof(int)*(curnode->g_val+1));
+
+    if (path == NULL)
+    {
+        FailSearch("out of memory for the path");
+        return(NULL);
+    }
+    path[0] = 0;
+    for (; curnode->parent != NULL; curnode = curnode->parent)
+        path[++path[0]] = curnode->move;
+    return(path);
+}
+
+// This function records a solution of an anytime search in the metrics of the thread.
+// A solution as long as the last one only tightens its bound. Once the list is full
+// the last entry is replaced, so the first solutions and the latest one are kept.
+void RecordIncumbent(int length, double bound, long long expanded, uint64_t elapsed_ns)
+{
+    struct P1Incumbent *incumbent;
+
+    if (metrics.nincumbents > 0 && metrics.incumbents[metrics.nincumbents-1].length == length)
+    {
+        metrics.incumbents[metrics.nincumbents-1].bound = bound;
+        return;
+    }
+    if (metrics.nincumbents < P1_MAX_INCUMBENTS)
+        metrics.nincumbents++;
+    incumbent = &metrics.incumbents[metrics.nincumbents-1];
+    incumbent->length = length;
+    incumbent->bound = bound;
+    incumbent->nodes_expanded = expanded;
+    incumbent->seconds = elapsed_ns*1e-9;
+}
+
+// This function performs anytime repairing A* (ARA*). A first solution is found quickly by
+// ordering the open list on g + e*h with the large inflation e of -weight, which is at most
+// e times as long as the shortest one. e is then lowered by -weightstep and the search goes
+// on from the nodes it already has instead of starting over: nodes whose cost improved
+// after they were expanded in the current round wait in the inconsistent list and are put
+// back into the open list for the next round. Every solution goes into the incumbents of
+// the statistics with the factor by which it may exceed the optimum, which reaches 1 at the
+// latest when e reaches 1. With -timelimit the best solution found so far is returned.
+int *ARAStar(State goal, State start)
+{
+    //////////////////////////////////////////////////////////////////// Parameters
+    int nodes_expanded=0,nodes_generated=1,max_depth=0,memory_consumed=0;
+    uint64_t start_time,end_time;
+    ////////////////////////////////////////////////////////////////////
+
+    start_time = NowNanoseconds();
+
+    int i, k, from;
+    double inflation = searchsettings.weight, bound, lowest, weight;
+    struct Node *curnode, *parentnode, *incumbent = NULL;
+    State child;
+    const struct MoveList *successors;
+
+    if (inflation < 1)
+        inflation = 1;
+    // _ff(weight,g,h) = (g + e*h)/(1 + e), which orders nodes like g + e*h
+    weight = 1/(1+inflation);
+
+    // create the root node of the search tree
+    curnode = CreateNode(start);
+    ClearClosedTable(&closed);
+    ClearClosedTable(&roundclosed);
+    incons.first = 0;
+    incons.count = 0;
+    UpdateClosedTable(&closed, start, 0);
+    if (curnode != NULL)
+    {
+        curnode->h_val = ComputeHeuristic(&htables, searchsettings.heuristic, goal, start);
+        curnode->f_val = _ff(weight,curnode->g_val,curnode->h_val);
+        PushOpenList(&openlist, curnode, curnode->f_val);
+    }
+
+    while (1)
+    {
+        // expand nodes until the incumbent is at the top of the open list, its key is then
+        // no larger than that of any node still to be expanded
+        while (openlist.size > 0)
+        {
+            parentnode = openlist.elements[0].nodeptr;
+            // skip stale copies of states that were reached again with a lower cost
+            if (parentnode->g_val > ExpandClosedEntry(&closed, parentnode->layout, parentnode->g_val))
+            {
+                PopOpenList(&openlist);
+                continue;
+            }
+            if (GoalTest(goal, parentnode->layout) == 1)
+            {
+                incumbent = parentnode;
+                break;
+            }
+            PopOpenList(&openlist);
+            UpdateClosedTable(&roundclosed, parentnode->layout, 0);
+
+            nodes_expanded++;
+            // give up once the time or memory budget is spent
+            if (OverBudget(nodes_expanded))
+                break;
+
+            from = GetBlank(parentnode->layout);
+            successors = &MoveTable[from][parentnode->move+1];
+            PHASE_BEGIN(PHASE_EXPAND);
+            for (k=0; k<successors->count; k++)
+            {
+                i = successors->move[k];
+                child = MoveBlank(parentnode->layout, from, successors->to[k]);
+                // skip configurations already reached at no greater cost
+                if (UpdateClosedTable(&closed, child, parentnode->g_val+1) == 0)
+                    continue;
+                nodes_generated++;
+                curnode = CreateNode(child);
+                if (curnode == NULL)
+                    break;
+                curnode->move = i;
+                curnode->g_val = parentnode->g_val+1;
+                if (max_depth < curnode->g_val)
+                    max_depth = curnode->g_val;
+                curnode->h_val = UpdateHeuristic(&htables, searchsettings.heuristic, parentnode->layout, child, parentnode->h_val);
+                curnode->f_val = _ff(weight,curnode->g_val,curnode->h_val);
+                curnode->parent = parentnode;
+                // a configuration is expanded at most once per round
+                if (LookupClosedTable(&roundclosed, child) == INT_MAX)
+                    PushOpenList(&openlist, curnode, curnode->f_val);
+                else
+                    PushNodeQueue(&incons, curnode);
+            }
+            PHASE_END(PHASE_EXPAND);
+            if (memory_consumed < nodes_generated-nodes_expanded)
+                memory_consumed = nodes_generated-nodes_expanded;
+        }
+        if (metrics.over_budget || incumbent == NULL)
+            break;
+
+        // no node still to be expanded can lead to a solution shorter than its g + h,
+        // the incumbent is at most g/(g + h) of the lowest of them longer than the optimum
+        lowest = incumbent->g_val;
+        for (k=0; k<openlist.size; k++)
+        {
+            curnode = openlist.elements[k].nodeptr;
+            if (curnode->g_val <= LookupClosedTable(&closed, curnode->layout) && lowest > curnode->g_val + curnode->h_val)
+                lowest = curnode->g_val + curnode->h_val;
+        }
+        for (k=0; k<(int)incons.count; k++)
+        {
+            curnode = incons.nodes[(incons.first + k) & (incons.capacity-1)];
+            if (curnode->g_val <= LookupClosedTable(&closed, curnode->layout) && lowest > curnode->g_val + curnode->h_val)
+                lowest = curnode->g_val + curnode->h_val;
+        }
+        bound = lowest > 0 ? incumbent->g_val/lowest : 1;
+        if (bound > inflation)
+            bound = inflation;
+        RecordIncumbent(incumbent->g_val, bound, nodes_expanded, NowNanoseconds() - start_time);
+        if (searchverbose)
+            printf("weight %.2f: solution of %d moves, at most %.3f times the optimum, %d nodes expanded, %.6f s\n",
+                   inflation, incumbent->g_val, bound, nodes_expanded, (NowNanoseconds() - start_time)*1e-9);
+        if (bound <= 1 || inflation <= 1)
+            break;
+
+        // next round with a lower inflation: the open and inconsistent nodes make up the
+        // new open list, ordered on the new keys
+        inflation -= searchsettings.weightstep;
+        if (inflation < 1 || searchsettings.weightstep <= 0)
+            inflation = 1;
+        weight = 1/(1+inflation);
+        while (openlist.size > 0)
+            PushNodeQueue(&incons, PopOpenList(&openlist));
+        while (incons.count > 0)
+        {
+            curnode = PopNodeQueue(&incons);
+            if (curnode->g_val > LookupClosedTable(&closed, curnode->layout))
+                continue;
+            curnode->f_val = _ff(weight,curnode->g_val,curnode->h_val);
+            PushOpenList(&openlist, curnode, curnode->f_val);
+        }
+        ClearClosedTable(&roundclosed);
+    }
+
+    /////////////////////////////////////////// Printing parameters
+    end_time = NowNanoseconds();
+    ReportSearch(nodes_expanded, nodes_generated, max_depth, memory_consumed, end_time - start_time);
+    ////////////////////////////////////////////////////////////////////
+    return(incumbent != NULL ? TracePath(incumbent) : NULL);
+}
+
+// This function creates a node variable. Copies the contents of the layout of the node,
+// the heuristic values are filled in by the searches that use them
+// returns NULL and fails the search when memory runs out
+struct Node *CreateNode(State a)
+{
+    struct Node *curnode;
+
+    curnode = (struct Node *)ArenaAlloc(&arena, sizeof(struct Node));
+    if (curnode == NULL)
+    {
+        FailSearch("out of memory for the nodes of the search");
+        return(NULL);
+    }
+    curnode->layout = a;
+    curnode->parent = NULL;
+    curnode->g_val = 0;
+    curnode->h_val = 0;
+    curnode->f_val = 0;
+    curnode->move = -1;
+
+    return(curnode);
+}
+
+// This function creates a search queue element
+// returns NULL and fails the search when memory runs out
+struct SearchQueueElement *CreateSearchQueueElement(struct Node *curnode)
+{
+    struct SearchQueueElement *cursqelement;
+
+    cursqelement = (struct SearchQueueElement*)ArenaAlloc(&arena, sizeof(struct SearchQueueElement));
+    if (cursqelement == NULL)
+    {
+        FailSearch("out of memory for the nodes of the search");
+        return(NULL);
+    }
+    cursqelement->nodeptr = curnode;
+    cursqelement->next = NULL;
+
+    return(cursqelement);
+
+}
+
+// This function appends a search queue element to the front of the queue - for Depth first search
+void AppendSearchQueueElementToFront(struct SearchQueueElement* cursqelement)
+{
+    PHASE_BEGIN(PHASE_QUEUE);
+    if (head != NULL)
+    {
+        cursqelement->next = head;
+        head = cursqelement;
+    }
+    else
+        head = cursqelement;
+    PHASE_END(PHASE_QUEUE);
+    return;
+}
+
+// This function makes sure n more nodes can be appended to the queue without growing it
+// returns 0 and fails the search if memory runs out
+int ReserveNodeQueue(struct NodeQueue *q, size_t n)
+{
+    size_t i, capacity;
+    struct Node **nodes;
+
+    if (q->count+n <= q->capacity)
+        return(1);
+    for (capacity = q->capacity ? q->capacity : 1024; capacity < q->count+n; capacity *= 2)
+        ;
+
+    // unwrap the ring into the new buffer
+    nodes = (struct Node **)malloc(sizeof(struct Node *)*capacity);
+    if (nodes == NULL)
+    {
+        FailSearch("out of memory for the frontier");
+        return(0);
+    }
+    for (i=0; i<q->count; i++)
+        nodes[i] = q->nodes[(q->first+i) & (q->capacity-1)];
+    free(q->nodes);
+    q->nodes = nodes;
+    q->capacity = capacity;
+    q->first = 0;
+    return(1);
+}
+
+// This function appends a node at the back of the queue in O(1)
+void PushNodeQueue(struct NodeQueue *q, struct Node *curnode)
+{
+    PHASE_BEGIN(PHASE_QUEUE);
+    if (q->count == q->capacity && ReserveNodeQueue(q, 1) == 0)
+    {
+        // the search has failed and stops, the node is dropped
+        PHASE_END(PHASE_QUEUE);
+        return;
+    }
+    q->nodes[(q->first+q->count) & (q->capacity-1)] = curnode;
+    q->count++;
+    PHASE_END(PHASE_QUEUE);
+}
+
+// This function removes and returns the node at the front of the queue in O(1)
+struct Node *PopNodeQueue(struct NodeQueue *q)
+{
+    struct Node *curnode;
+
+    PHASE_BEGIN(PHASE_QUEUE);
+    curnode = q->nodes[q->first];
+    q->first = (q->first+1) & (q->capacity-1);
+    q->count--;
+    PHASE_END(PHASE_QUEUE);
+    return(curnode);
+}
+
+// returns 1 if element a has to be expanded before element b
+#define OpenListBefore(a,b) ((a).key < (b).key || ((a).key == (b).key && (a).h_val < (b).h_val))
+
+// This function inserts a node into the open list with the given priority in O(log n)
+void PushOpenList(struct OpenList *open, struct Node *curnode, float key)
+{
+    int i, parent, capacity;
+    struct OpenListElement element, *elements;
+
+    PHASE_BEGIN(PHASE_QUEUE);
+    if (open->size == open->capacity)
+    {
+        capacity = open->capacity ? 2*open->capacity : 1024;
+        elements = (struct OpenListElement *)realloc(open->elements, sizeof(struct OpenListElement)*capacity);
+        if (elements == NULL)
+        {
+            // the search has failed and stops, the node is dropped
+            FailSearch("out of memory for the open list");
+            PHASE_END(PHASE_QUEUE);
+            return;
+        }
+        open->elements = elements;
+        open->capacity = capacity;
+    }
+
+    element.key = key;
+    element.h_val = curnode->h_val;
+    element.nodeptr = curnode;
+
+    // sift the new element up from the last leaf
+    i = open->size++;
+    while (i > 0)
+    {
+        parent = (i-1)/2;
+        if (!OpenListBefore(element, open->elements[parent]))
+            break;
+        open->elements[i] = open->elements[parent];
+        i = parent;
+    }
+    open->elements[i] = element;
+    PHASE_END(PHASE_QUEUE);
+}
+
+// This function removes and returns the node with the lowest priority in O(log n)
+struct Node *PopOpenList(struct OpenList *open)
+{
+    int i, child;
+    struct Node *curnode;
+    struct OpenListElement last;
+
+    PHASE_BEGIN(PHASE_QUEUE);
+    curnode = open->elements[0].nodeptr;
+    last = open->elements[--open->size];
+
+    // sift the last element down from the root
+    i = 0;
+    while ((child = 2*i+1) < open->size)
+    {
+        if (child+1 < open->size && OpenListBefore(open->elements[child+1], open->elements[child]))
+            child++;
+        if (!OpenListBefore(open->elements[child], last))
+            break;
+        open->elements[i] = open->elements[child];
+        i = child;
+    }
+    open->elements[i] = last;
+    PHASE_END(PHASE_QUEUE);
+    return(curnode);
+}
+
+// size of the block header, rounded up so that the first allocation is aligned
+#define ARENA_HEADER ((sizeof(struct ArenaBlock)+ARENA_ALIGN-1) & ~(size_t)(ARENA_ALIGN-1))
+
+// This function returns size bytes of memory that stay valid until the arena is reset,
+// NULL if malloc has no more
+void *ArenaAlloc(struct Arena *a, size_t size)
+{
+    void *p;
+    size_t blocksize;
+    struct ArenaBlock *block;
+
+    size = (size+ARENA_ALIGN-1) & ~(size_t)(ARENA_ALIGN-1);
+    if ((size_t)(a->end - a->cur) < size)
+    {
+        // go on in the next block kept from an earlier search, or start a new one after
+        // the current block. The rest of the current one is left unused
+        block = (a->blocks != NULL) ? a->blocks->next : a->first;
+        if (block == NULL || block->size < ARENA_HEADER + size)
+        {
+            blocksize = ARENA_HEADER + (size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE);
+            block = (struct ArenaBlock *)malloc(blocksize);
+            if (block == NULL)
+                return(NULL);
+            block->size = blocksize;
+            if (a->blocks != NULL)
+            {
+                block->next = a->blocks->next;
+                a->blocks->next = block;
+            }
+            else
+            {
+                block->next = a->first;
+                a->first = block;
+            }
+            a->bytesreserved += blocksize;
+        }
+        a->blocks = block;
+        a->cur = (char *)block + ARENA_HEADER;
+        a->end = (char *)block + block->size;
+    }
+
+    p = a->cur;
+    a->cur += size;
+    a->bytesused += size;
+    return(p);
+}
+
+// This function frees every node at once but keeps the blocks, the next search allocates
+// from them again starting with the first
+void ArenaReset(struct Arena *a)
+{
+    a->blocks = NULL;
+    a->cur = a->end = NULL;
+    a->bytesused = 0;
+}
+
+// This function gives all blocks back to malloc
+void FreeArena(struct Arena *a)
+{
+    struct ArenaBlock *block;
+
+    while (a->first != NULL)
+    {
+        block = a->first;
+        a->first = block->next;
+        free(block);
+    }
+    a->blocks = NULL;
+    a->cur = a->end = NULL;
+    a->bytesused = 0;
+    a->bytesreserved = 0;
+}
+
+// This function hashes a configuration (64 bit finalizer of MurmurHash3)
+uint64_t HashState(State s)
+{
+    uint64_t h;
+
+#if N == 5
+    h = (uint64_t)s ^ ((uint64_t)(s >> 64) * 0x9e3779b97f4a7c15ULL);
+#else
+    h = (uint64_t)s;
+#endif
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return(h);
+}
+
+// This function returns the slot holding configuration s, or the empty slot where it
+// has to be inserted. Linear probing, the table is never more than 3/4 full.
+struct ClosedEntry *FindClosedEntry(struct ClosedTable *t, State s)
+{
+    size_t i, mask = t->capacity-1;
+
+    i = HashState(s) & mask;
+    while (t->entries[i].layout != 0 && t->entries[i].layout != s)
+        i = (i+1) & mask;
+    return(&t->entries[i]);
+}
+
+// This function doubles the number of slots of the table.
+// returns 0 if that would exceed the memory cap of the table
+int GrowClosedTable(struct ClosedTable *t)
+{
+    size_t i, oldcapacity = t->capacity;
+    struct ClosedEntry *oldentries = t->entries;
+
+    t->capacity = oldcapacity ? 2*oldcapacity : CLOSED_INITIAL_SIZE;
+    if (t->capacity*sizeof(struct ClosedEntry) > t->maxbytes ||
+            (t->entries = (struct ClosedEntry *)calloc(t->capacity, sizeof(struct ClosedEntry))) == NULL)
+    {
+        t->capacity = oldcapacity;
+        t->entries = oldentries;
+        return(0);
+    }
+
+    for (i=0; i<oldcapacity; i++)
+        if (oldentries[i].layout != 0)
+            *FindClosedEntry(t, oldentries[i].layout) = oldentries[i];
+    free(oldentries);
+    return(1);
+}
+
+// This function records that configuration s has been reached with cost g.
+// returns 0 if s was already reached with a cost not greater than g (a duplicate), else 1.
+// Once the table has hit its memory cap new configurations are no longer recorded and
+// are reported as not seen, so the searches stay complete but prune less.
+int UpdateClosedTable(struct ClosedTable *t, State s, int g)
+{
+    int full = 0;
+    struct ClosedEntry *entry;
+
+    if (4*(t->count+1) > 3*t->capacity)
+        full = !GrowClosedTable(t);
+    if (t->capacity == 0)
+        return(1);
+
+    entry = FindClosedEntry(t, s);
+    if (entry->layout == s)
+    {
+        if (entry->g_val <= g)
+        {
+            metrics.duplicates++;
+            return(0);
+        }
+        entry->g_val = g;
+        if (entry->expanded)
+        {
+            // the configuration goes back to the open list
+            entry->expanded = 0;
+            metrics.reopenings++;
+        }
+        else
+            metrics.improvements++;
+        return(1);
+    }
+    if (!full)
+    {
+        entry->layout = s;
+        entry->g_val = g;
+        entry->expanded = 0;
+        t->count++;
+    }
+    return(1);
+}
+
+// This function returns the lowest cost with which configuration s has been reached,
+// INT_MAX if it has not been recorded. If that cost is g the configuration is marked as
+// expanded, a later cheaper path to it is then counted as a reopening
+int ExpandClosedEntry(struct ClosedTable *t, State s, int g)
+{
+    struct ClosedEntry *entry;
+
+    if (t->capacity == 0)
+        return(INT_MAX);
+    entry = FindClosedEntry(t, s);
+    if (entry->layout != s)
+        return(INT_MAX);
+    if (entry->g_val == g)
+        entry->expanded = 1;
+    return(entry->g_val);
+}
+
+// This function returns the lowest cost with which configuration s has been reached,
+// INT_MAX if it has not been recorded
+int LookupClosedTable(struct ClosedTable *t, State s)
+{
+    struct ClosedEntry *entry;
+
+    if (t->capacity == 0)
+        return(INT_MAX);
+    entry = FindClosedEntry(t, s);
+    return(entry->layout == s ? entry->g_val : INT_MAX);
+}
+
+void ClearClosedTable(struct ClosedTable *t)
+{
+    if (t->count > 0)
+        memset(t->entries, 0, sizeof(struct ClosedEntry)*t->capacity);
+    t->count = 0;
+}
+
+void FreeClosedTable(struct ClosedTable *t)
+{
+    free(t->entries);
+    t->entries = NULL;
+    t->capacity = 0;
+    t->count = 0;
+}
+
+// This function releases everything a search allocated. All nodes and search queue
+// elements live in the arena, so they go away with its blocks at once
+void FreeSearchMemory()
+{
+    head = NULL;
+    FreeArena(&arena);
+
+    free(frontier.nodes);
+    frontier.nodes = NULL;
+    frontier.capacity = 0;
+    frontier.first = 0;
+    frontier.count = 0;
+
+    free(openlist.elements);
+    openlist.elements = NULL;
+    openlist.capacity = 0;
+    openlist.size = 0;
+
+    FreeClosedTable(&closed);
+
+    free(backfrontier.nodes);
+    memset(&backfrontier, 0, sizeof(backfrontier));
+    free(backopenlist.elements);
+    memset(&backopenlist, 0, sizeof(backopenlist));
+    FreeClosedTable(&backclosed);
+
+    free(incons.nodes);
+    memset(&incons, 0, sizeof(incons));
+    FreeClosedTable(&roundclosed);
+}
+
+// This function empties the search structures of the thread between two searches.
+// The nodes are released, the arena, heap, queue and closed table keep their memory
+void ResetSearchMemory()
+{
+    head = NULL;
+    ArenaReset(&arena);
+    frontier.first = 0;
+    frontier.count = 0;
+    openlist.size = 0;
+    ClearClosedTable(&closed);
+    backfrontier.first = 0;
+    backfrontier.count = 0;
+    backopenlist.size = 0;
+    ClearClosedTable(&backclosed);
+    incons.first = 0;
+    incons.count = 0;
+    ClearClosedTable(&roundclosed);
+}
+
+// This function reads the start states of a batch file, one per line in the format of
+// -start. Empty lines and lines starting with # are skipped, lines that can not be read
+// (including those longer than BATCH_LINE_LENGTH) are kept as invalid instances so that
+// the results still match the file.
+// returns 1 on success else 0
+int ReadBatch(struct Batch *b, const char *filename)
+{
+    FILE *fp;
+    char line[BATCH_LINE_LENGTH];
+    char *text;
+    int capacity = 0, lineno = 0, overlong, c;
+    struct BatchInstance *instance;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL)
+    {
+        perror(filename);
+        return(0);
+    }
+    b->instances = NULL;
+    b->count = 0;
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        lineno++;
+        // a line longer than the buffer is one invalid instance, the rest of it is skipped
+        overlong = 0;
+        if (strchr(line, '\n') == NULL && (c = fgetc(fp)) != EOF && c != '\n')
+        {
+            overlong = 1;
+            while ((c = fgetc(fp)) != EOF && c != '\n')
+                ;
+        }
+        text = line + strspn(line, " \t\r\n");
+        if (*text == '\0' || *text == '#')
+            continue;
+        if (b->count == capacity)
+        {
+            capacity = capacity ? 2*capacity : 256;
+            b->instances = (struct BatchInstance *)realloc(b->instances, sizeof(struct BatchInstance)*capacity);
+        }
+        instance = &b->instances[b->count++];
+        memset(instance, 0, sizeof(*instance));
+        instance->line = lineno;
+        instance->valid = !overlong && ParseLayout(text, &instance->start);
+        instance->moves = -1;
+        instance->optimal = -1;
+    }
+    fclose(fp);
+    return(1);
+}
+
+// This function prints the results that are complete and next in order. It is called with
+// the lock of the batch held, so the lines come out in the order of the file whichever
+// thread finishes first
+void FlushBatchResults(struct Batch *b)
+{
+    struct BatchInstance *instance;
+
+    while (b->printed < b->count && b->instances[b->printed].done)
+    {
+        instance = &b->instances[b->printed];
+        // the machine readable formats only hold records, unsolvable instances have no moves
+        if (statsformat != STATS_TEXT && instance->valid == 0)
+            fprintf(stderr, "line %d does not hold a tile configuration\n", instance->line);
+        else if (statsformat != STATS_TEXT)
+            PrintStatsRecord(instance->line, AlgorithmNames[b->algorithm], instance->moves, &instance->stats);
+        else if (instance->valid == 0)
+            printf("%d invalid\n", instance->line);
+        else if (instance->solvable == 0)
+            printf("%d unsolvable\n", instance->line);
+        else if (instance->moves < 0)
+            printf("%d unsolved %lld %f\n", instance->line, instance->stats.nodes_expanded, instance->elapsed_ns*1e-9);
+        else
+            printf("%d %d %lld %f\n", instance->line, instance->moves, instance->stats.nodes_expanded, instance->elapsed_ns*1e-9);
+        b->printed++;
+    }
+    fflush(stdout);
+}
+
+// This function is the body of every batch thread. It takes the next unsolved instance
+// until there are none left, solving each with the search structures of the thread
+void *BatchWorker(void *arg)
+{
+    struct Batch *b = (struct Batch *)arg;
+    struct BatchInstance *instance;
+    uint64_t start_time;
+    int i, *path;
+
+    searchverbose = 0;
+    searchsettings = b->settings;
+    htables.pdbs = b->pdbs;
+    while ((i = atomic_fetch_add(&b->next, 1)) < b->count)
+    {
+        instance = &b->instances[i];
+        instance->solvable = instance->valid && IsSolvable(b->goal, instance->start);
+        if (instance->solvable)
+        {
+            memset(&searchstats, 0, sizeof(searchstats));
+            start_time = NowNanoseconds();
+            path = Solve(b->algorithm, b->goal, instance->start);
+            instance->elapsed_ns = NowNanoseconds() - start_time;
+            instance->moves = (path != NULL) ? path[0] : -1;
+            instance->stats = searchstats;
+            free(path);
+            ResetSearchMemory();
+        }
+
+        pthread_mutex_lock(&b->lock);
+        instance->done = 1;
+        FlushBatchResults(b);
+        pthread_mutex_unlock(&b->lock);
+    }
+    FreeSearchMemory();
+    return(NULL);
+}
+
+// This function solves every start state of a batch file with nthreads threads and prints
+// one line per instance in the order of the file: the line number, the number of moves,
+// the nodes expanded and the wall clock time in seconds, or with -stats json|csv all
+// statistics of the search together with the line number.
+// returns the exit status of the program
+int SolveBatch(const char *filename, int algorithm, State goal, int nthreads, int korf)
+{
+    struct Batch b;
+    pthread_t *threads;
+    int i, started;
+
+    if (ReadBatch(&b, filename) == 0)
+        return(1);
+    if (korf)
+        ConvertKorfInstances(&b);
+    if (nthreads > b.count)
+        nthreads = b.count;
+    if (nthreads < 1)
+        nthreads = 1;
+
+    b.algorithm = algorithm;
+    b.goal = goal;
+    b.pdbs = htables.pdbs;
+    b.settings = searchsettings;
+    atomic_init(&b.next, 0);
+    pthread_mutex_init(&b.lock, NULL);
+    b.printed = 0;
+
+    if (statsformat == STATS_TEXT)
+        printf("# line moves expanded seconds\n");
+    else
+        PrintStatsHeader();
+    threads = (pthread_t *)malloc(sizeof(pthread_t)*nthreads);
+    for (started=0; started<nthreads; started++)
+        if (pthread_create(&threads[started], NULL, BatchWorker, &b) != 0)
+            break;
+    // without any thread the instances are solved here
+    if (started == 0)
+        BatchWorker(&b);
+    for (i=0; i<started; i++)
+        pthread_join(threads[i], NULL);
+
+    pthread_mutex_destroy(&b.lock);
+    free(threads);
+    free(b.instances);
+    return(0);
+}
+
+// This function returns the time of a monotonic clock in nanoseconds
+uint64_t NowNanoseconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return((uint64_t)now.tv_sec*1000000000ULL + (uint64_t)now.tv_nsec);
+}
+
+// This function starts the metrics of the calling thread from zero. The memory that the
+// search structures kept from earlier searches is not counted in the peak of the next one
+void ResetMetrics()
+{
+    memset(&metrics, 0, sizeof(metrics));
+    metrics.start_bytes = SearchMemoryBytes();
+}
+
+// This function adds the counters and timers of one thread to those of another
+void AddMetrics(struct SearchMetrics *to, const struct SearchMetrics *from)
+{
+    int phase;
+
+    to->duplicates += from->duplicates;
+    to->improvements += from->improvements;
+    to->reopenings += from->reopenings;
+    to->peak_bytes += from->peak_bytes;
+    to->over_budget |= from->over_budget;
+    to->failed |= from->failed;
+    for (phase=0; phase<NPHASES; phase++)
+        to->phase_ns[phase] += from->phase_ns[phase];
+}
+
+// This function returns the bytes held by the search structures of the calling thread.
+// None of them shrinks during a search, so at its end this is the peak of the search
+size_t SearchMemoryBytes()
+{
+    return(arena.bytesreserved + (closed.capacity + backclosed.capacity + roundclosed.capacity)*sizeof(struct ClosedEntry) +
+           (openlist.capacity + backopenlist.capacity)*sizeof(struct OpenListElement) +
+           (frontier.capacity + backfrontier.capacity + incons.capacity)*sizeof(struct Node *));
+}
+
+// This function prints the column names of the CSV format, nothing for the other formats
+void PrintStatsHeader()
+{
+    int phase;
+
+    if (statsformat != STATS_CSV)
+        return;
+    printf("instance,algorithm,moves,nodes_expanded,nodes_generated,duplicates,improvements,reopenings,max_depth,"
+           "memory_consumed,arena_bytes,peak_bytes,seconds,nodes_per_second,over_budget");
+    for (phase=0; phase<NPHASES; phase++)
+        printf(",%s_ns", PhaseNames[phase]);
+    printf(",incumbents\n");
+}
+
+// This function prints the statistics of a search in the format chosen with -stats.
+// moves is the length of the solution, -1 if none was found. The phase times stay 0
+// unless the solver was built with -DPHASE_TIMERS
+void PrintStatsRecord(int instance, const char *algorithm, int moves, const struct SearchStats *s)
+{
+    int phase, i;
+    double seconds = s->elapsed_ns*1e-9;
+    double rate = s->elapsed_ns > 0 ? s->nodes_expanded/seconds : 0;
+
+    if (statsformat == STATS_CSV)
+    {
+        printf("%d,%s,%d,%lld,%lld,%lld,%lld,%lld,%d,%lld,%zu,%zu,%.9f,%.0f,%d", instance, algorithm, moves,
+               s->nodes_expanded, s->nodes_generated, s->duplicates, s->improvements, s->reopenings, s->max_depth,
+               s->memory_consumed, s->arena_bytes, s->peak_bytes, seconds, rate, s->over_budget);
+        for (phase=0; phase<NPHASES; phase++)
+            printf(",%llu", (unsigned long long)s->phase_ns[phase]);
+        // moves:bound of every incumbent, separated by spaces
+        printf(",");
+        for (i=0; i<s->nincumbents; i++)
+            printf("%s%d:%.3f", i ? " " : "", s->incumbents[i].length, s->incumbents[i].bound);
+        printf("\n");
+    }
+    else if (statsformat == STATS_JSON)
+    {
+        // one object per line
+        printf("{\"instance\": %d, \"algorithm\": \"%s\", \"moves\": %d, \"nodes_expanded\": %lld, "
+               "\"nodes_generated\": %lld, \"duplicates\": %lld, \"improvements\": %lld, \"reopenings\": %lld, \"max_depth\": %d, "
+               "\"memory_consumed\": %lld, \"arena_bytes\": %zu, \"peak_bytes\": %zu, \"seconds\": %.9f, "
+               "\"nodes_per_second\": %.0f, \"over_budget\": %d", instance, algorithm, moves,
+               s->nodes_expanded, s->nodes_generated, s->duplicates, s->improvements, s->reopenings, s->max_depth,
+               s->memory_consumed, s->arena_bytes, s->peak_bytes, seconds, rate, s->over_budget);
+        for (phase=0; phase<NPHASES; phase++)
+            printf(", \"%s_ns\": %llu", PhaseNames[phase], (unsigned long long)s->phase_ns[phase]);
+        printf(", \"incumbents\": [");
+        for (i=0; i<s->nincumbents; i++)
+            printf("%s{\"moves\": %d, \"bound\": %.6f, \"nodes_expanded\": %lld, \"seconds\": %.9f}", i ? ", " : "",
+                   s->incumbents[i].length, s->incumbents[i].bound, s->incumbents[i].nodes_expanded, s->incumbents[i].seconds);
+        printf("]}\n");
+    }
+    else
+    {
+        printf("Nodes Expanded : %lld\n", s->nodes_expanded);
+        printf("Nodes Generated : %lld\n", s->nodes_generated);
+        printf("Duplicates : %lld\n", s->duplicates);
+        printf("Improvements : %lld\n", s->improvements);
+        printf("Reopenings : %lld\n", s->reopenings);
+        printf("Max Depth Reached : %d\n", s->max_depth);
+        printf("Memory Consumed : %lld\n", s->memory_consumed);
+        printf("Arena Bytes Used : %zu\n", s->arena_bytes);
+        printf("Peak Bytes : %zu\n", s->peak_bytes);
+        printf("Computation Time : %f s\n", seconds);
+        printf("Nodes per Second : %.0f\n", rate);
+        if (s->over_budget)
+            printf("Search gave up on its time or memory budget\n");
+        for (i=0; i<s->nincumbents; i++)
+            printf("Incumbent : %d moves, at most %.3f times the optimum, %lld nodes expanded, %f s\n",
+                   s->incumbents[i].length, s->incumbents[i].bound, s->incumbents[i].nodes_expanded, s->incumbents[i].seconds);
+#ifdef PHASE_TIMERS
+        for (phase=0; phase<NPHASES; phase++)
+            printf("Time in %s : %f s\n", PhaseNames[phase], s->phase_ns[phase]*1e-9);
+#endif
+    }
+}
+
+// This function checks whether the search of the calling thread has spent its time or
+// memory budget. The clock is only read every BUDGET_POLL_INTERVAL nodes, once spent the
+// budget stays spent until the next ResetMetrics.
+// returns 1 if the search should give up else 0
+// This function gives up the search of the thread because memory or a thread can not be
+// had. The search stops as if it were over its budget and P1Solve reports P1_ERROR; only
+// the program prints the reason
+void FailSearch(const char *reason)
+{
+#ifdef P1_LIBRARY
+    (void)reason;
+#else
+    if (metrics.failed == 0)
+        fprintf(stderr, "%s\n", reason);
+#endif
+    metrics.failed = 1;
+    metrics.over_budget = 1;
+}
+
+int OverBudget(long long nodes)
+{
+    if ((nodes & (BUDGET_POLL_INTERVAL-1)) != 0 || metrics.over_budget)
+        return(metrics.over_budget);
+    if ((searchdeadline != 0 && NowNanoseconds() > searchdeadline) ||
+            (searchsettings.memorylimit != 0 && SearchMemoryBytes() > searchsettings.memorylimit))
+        metrics.over_budget = 1;
+    return(metrics.over_budget);
+}
+
+// This function returns the next number of a splitmix64 sequence, which is the same on
+// every machine and for every seed including 0
+uint64_t NextRandom(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return(z ^ (z >> 31));
+}
+
+// This function fills a batch with 8-puzzle instances of every optimal solution length
+// from 1 to 31, perdepth of each or all there are. A breadth first search from the goal
+// finds the distance of all 181440 configurations, the instances are drawn from each
+// level with the seed, so the same seed always gives the same instances.
+// The 15-puzzle instances are random walks of every length from 1 to BENCH_15_MAX_LENGTH
+// that IDA* can not shorten, so their length is optimal. Korf's 100 instances are far
+// beyond what breadth first search can hold, they are run with -batch file -korf.
+// returns 1 on success else 0
+int GenerateDepthSet(struct Batch *b, State goal, int perdepth, uint64_t seed)
+{
+#if N == 3
+    struct ClosedTable distances = {NULL, 0, 0, SIZE_MAX};
+    struct BatchInstance *instance;
+    State *states, parent, child, swap;
+    const struct MoveList *successors;
+    size_t nstates = 0, next, level[EIGHT_PUZZLE_MAX_LENGTH+2], lo, n, k, r;
+    int i, d, from;
+
+    states = (State *)malloc(sizeof(State)*EIGHT_PUZZLE_STATES);
+    b->count = 0;
+    b->instances = (struct BatchInstance *)calloc((size_t)EIGHT_PUZZLE_MAX_LENGTH*(perdepth > 0 ? perdepth : 1), sizeof(struct BatchInstance));
+    if (states == NULL || b->instances == NULL)
+    {
+        fprintf(stderr, "out of memory for the benchmark instances\n");
+        free(states);
+        free(b->instances);
+        return(0);
+    }
+    states[nstates++] = goal;
+    UpdateClosedTable(&distances, goal, 0);
+    for (next=0; next<nstates; next++)
+    {
+        parent = states[next];
+        d = LookupClosedTable(&distances, parent);
+        from = GetBlank(parent);
+        successors = &MoveTable[from][0];
+        for (i=0; i<successors->count; i++)
+        {
+            child = MoveBlank(parent, from, successors->to[i]);
+            if (UpdateClosedTable(&distances, child, d+1) == 1)
+                states[nstates++] = child;
+        }
+    }
+
+    // the states are in order of distance, find where each level starts
+    for (d=0, next=0; d<=EIGHT_PUZZLE_MAX_LENGTH+1; d++)
+    {
+        while (next < nstates && LookupClosedTable(&distances, states[next]) < d)
+            next++;
+        level[d] = next;
+    }
+
+    for (d=1; d<=EIGHT_PUZZLE_MAX_LENGTH; d++)
+    {
+        lo = level[d];
+        n = level[d+1] - lo;
+        for (k=0; k<(size_t)perdepth && k<n; k++)
+        {
+            // draw without replacement by shuffling the front of the level
+            r = k + NextRandom(&seed) % (n-k);
+            swap = states[lo+k];
+            states[lo+k] = states[lo+r];
+            states[lo+r] = swap;
+
+            instance = &b->instances[b->count++];
+            instance->start = states[lo+k];
+            instance->line = b->count;
+            instance->valid = 1;
+            instance->moves = -1;
+            instance->optimal = d;
+        }
+    }
+    free(states);
+    FreeClosedTable(&distances);
+    return(1);
+#elif N == 4
+    struct BatchInstance *instance;
+    State s;
+    const struct MoveList *successors;
+    int i, j, d, k, step, tries, from, lastmove, length, *path;
+    int heuristic = searchsettings.heuristic, verbose = searchverbose;
+
+    b->count = 0;
+    b->instances = (struct BatchInstance *)calloc((size_t)BENCH_15_MAX_LENGTH*(perdepth > 0 ? perdepth : 1), sizeof(struct BatchInstance));
+    if (b->instances == NULL)
+    {
+        fprintf(stderr, "out of memory for the benchmark instances\n");
+        return(0);
+    }
+    searchsettings.heuristic = HEURISTIC_LINEAR;
+    searchverbose = 0;
+    for (d=1; d<=BENCH_15_MAX_LENGTH; d++)
+        for (k=0; k<perdepth; k++)
+            for (tries=0; tries<BENCH_15_TRIES; tries++)
+            {
+                // a walk of d moves that never undoes the move before
+                s = goal;
+                lastmove = -1;
+                for (step=0; step<d; step++)
+                {
+                    from = GetBlank(s);
+                    successors = &MoveTable[from][lastmove+1];
+                    i = (int)(NextRandom(&seed) % successors->count);
+                    s = MoveBlank(s, from, successors->to[i]);
+                    lastmove = successors->move[i];
+                }
+                path = Solve(ALGORITHM_IDASTAR, goal, s);
+                length = (path != NULL) ? path[0] : -1;
+                free(path);
+                ResetSearchMemory();
+                for (j=0; j<b->count && b->instances[j].start != s; j++)
+                    ;
+                if (length != d || j < b->count)
+                    continue;
+
+                instance = &b->instances[b->count++];
+                instance->start = s;
+                instance->line = b->count;
+                instance->valid = 1;
+                instance->moves = -1;
+                instance->optimal = d;
+                break;
+            }
+    searchsettings.heuristic = heuristic;
+    searchverbose = verbose;
+    return(1);
+#else
+    (void)b;
+    (void)goal;
+    (void)perdepth;
+    (void)seed;
+    fprintf(stderr, "the generated benchmark is for the 8- and 15-puzzle, give the instances with -batch file\n");
+    return(0);
+#endif
+}
+
+// This function renumbers instances written for the goal with the blank in the first cell,
+// as Korf's 100 15-puzzle instances are. Turning the board half way round puts the blank
+// in the last cell, and tile t becomes NTILES-t; neither changes how long a solution is.
+void ConvertKorfInstances(struct Batch *b)
+{
+    int i, p, tile, tiles[NTILES];
+
+    for (i=0; i<b->count; i++)
+    {
+        if (b->instances[i].valid == 0)
+            continue;
+        for (p=0; p<NTILES; p++)
+        {
+            tile = GetTile(b->instances[i].start, p);
+            tiles[NTILES-1-p] = (tile == BLANK) ? BLANK : NTILES-tile;
+        }
+        b->instances[i].start = PackTiles(tiles);
+    }
+}
+
+// This function returns the index of the given percentile (nearest rank) in n sorted values
+int PercentileIndex(int n, int percent)
+{
+    return((n*percent + 99)/100 - 1);
+}
+
+// This function compares two doubles for qsort
+int CompareDoubles(const void *x, const void *y)
+{
+    double a = *(const double *)x, b = *(const double *)y;
+
+    return((a > b) - (a < b));
+}
+
+// This function compares two long longs for qsort
+int CompareLongLongs(const void *x, const void *y)
+{
+    long long a = *(const long long *)x, b = *(const long long *)y;
+
+    return((a > b) - (a < b));
+}
+
+// This function solves every instance of a batch, one at a time, with one algorithm and
+// heuristic (-1 for the algorithms that do not take one) and fills a row of the benchmark.
+// Times and expansions are those of the instances solved within the budget. Where the
+// optimal length of an instance is known, a path of another length from an algorithm that
+// should find a shortest one, or a path shorter than it from any, is not counted as solved.
+void BenchmarkCombination(struct Batch *b, State goal, int algorithm, int heuristic, struct BenchResult *r)
+{
+    int i, *path, optimal;
+    double *seconds;
+    long long *expanded;
+
+    memset(r, 0, sizeof(*r));
+    snprintf(r->algorithm, sizeof(r->algorithm), "%s", AlgorithmNames[algorithm]);
+    if (heuristic >= 0)
+    {
+        searchsettings.heuristic = heuristic;
+        snprintf(r->heuristic, sizeof(r->heuristic), "%s", HeuristicNames[heuristic]);
+    }
+    else
+        snprintf(r->heuristic, sizeof(r->heuristic), "%s", algorithm == ALGORITHM_GBEFS ? "misplaced" : "none");
+
+    seconds = (double *)malloc(sizeof(double)*(b->count+1));
+    expanded = (long long *)malloc(sizeof(long long)*(b->count+1));
+    for (i=0; i<b->count; i++)
+    {
+        if (b->instances[i].valid == 0)
             continue;
-        }
-        for (i=0; i<MAXVALIDMOVES; i++)
+        r->instances++;
+        memset(&searchstats, 0, sizeof(searchstats));
+        path = Solve(algorithm, goal, b->instances[i].start);
+        optimal = b->instances[i].optimal;
+        if (searchstats.over_budget)
+            r->over_budget++;
+        else if (path != NULL && optimal >= 0 && (path[0] < optimal ||
+                 (path[0] != optimal && algorithm != ALGORITHM_DFS && algorithm != ALGORITHM_GBEFS)))
+            fprintf(stderr, "%s/%s: %d moves on instance %d, the shortest path has %d\n", r->algorithm, r->heuristic,
+                    path[0], b->instances[i].line, optimal);
+        else if (path != NULL)
         {
-            if (IsValidMove(blank, i) == 1)
-            {
-                int lastmove = temphead->nodeptr->move;
-                if( (i==0 && lastmove==1) || (i==1 && lastmove==0) || (i==2 && lastmove==3) || (i==3 && lastmove==2) ) continue;
-                ///////////////////////////////////////////////////////////////
-                nodes_generated++;
-                ///////////////////////////////////////////////////////////////
-                curnode = CreateNode(temphead->nodeptr->layout);
-                MoveTile(curnode->layout, blank, i);
-                curnode->move = i;
-                curnode->g_val = temphead->nodeptr->g_val+1;
-                ////////////////////////////////////////////////////Computing max depth reached
-                if(max_depth < curnode->g_val){
-                    max_depth = curnode->g_val;
-                }
-                ////////////////////////////////////////////////////
-                //curnode->h_val = HeuristicMisplacedTiles(goal,curnode->layout);
-                curnode->h_val = HeuristicManhattanDistance(goal,curnode->layout);
-                //curnode->f_val = curnode->g_val + curnode->h_val;
-                curnode->f_val = _ff(w,curnode->g_val,curnode->h_val);
-                curnode->parent = temphead->nodeptr;
-                cursqelement = CreateSearchQueueElement(curnode);
-                cursqelement->next = NULL;
-                InsertSearchQueueElementPriorityf(cursqelement);
-            }
-        }
-        /////////////////////////////////////////////// Computing Memory consumed
-        if(memory_consumed < nodes_generated-nodes_expanded){
-            memory_consumed = nodes_generated-nodes_expanded;
+            seconds[r->solved] = searchstats.elapsed_ns*1e-9;
+            expanded[r->solved] = searchstats.nodes_expanded;
+            r->solved++;
         }
-        ///////////////////////////////////////////////
-        struct SearchQueueElement* temp;
-        temp = temphead;
-        temphead = head;
-        free(temp);
+        free(path);
+        ResetSearchMemory();
     }
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
-    return(path);
+
+    if (r->solved > 0)
+    {
+        qsort(seconds, r->solved, sizeof(double), CompareDoubles);
+        qsort(expanded, r->solved, sizeof(long long), CompareLongLongs);
+        r->median_seconds = seconds[PercentileIndex(r->solved, 50)];
+        r->p95_seconds = seconds[PercentileIndex(r->solved, 95)];
+        r->median_expanded = expanded[PercentileIndex(r->solved, 50)];
+        r->p95_expanded = expanded[PercentileIndex(r->solved, 95)];
+    }
+    free(seconds);
+    free(expanded);
 }
 
-// This function performs IDA* search
-int *IDAStar(int **goal, int **start)
+// This function prints a row of the benchmark table in the format chosen with -stats,
+// or the column names when r is NULL. A CSV table starts with the threads and time limit
+// it was run with, so that a baseline is only compared with runs under the same settings
+void PrintBenchResult(const struct BenchResult *r)
 {
-/*    start[0][0]=2;
-    start[0][1]=9;
-    start[0][2]=4;
-    start[1][0]=3;
-    start[1][1]=1;
-    start[1][2]=6;
-    start[2][0]=7;
-    start[2][1]=5;
-    start[2][2]=8;
-    
-    start[0][0]=4;
-    start[0][1]=1;
-    start[0][2]=2;
-    start[1][0]=9;
-    start[1][1]=8;
-    start[1][2]=7;
-    start[2][0]=6;
-    start[2][1]=3;
-    start[2][2]=5;
-*/
-    //////////////////////////////////////////////////////////////////// Parameters
-    int nodes_expanded=0,totalnodes_expanded=0,nodes_generated=1,totalnodes_generated=1,max_depth=0,memory_consumed=0;
-    float computation_time,start_time,end_time;
-    ////////////////////////////////////////////////////////////////////
-    
-    ////////////////////////////////////////////////////////////////////Computing start time
-    start_time = clock();
-    ////////////////////////////////////////////////////////////////////
-
-    int i;
-    struct Node *curnode;
-    struct SearchQueueElement *cursqelement, *temphead;
-    Location blank;
-    int *path = NULL;
-    
-    int fdepth = 0,nextmin_fdepth=999999;
-    
-    curnode = CreateNode(start);    
-    fdepth = curnode->f_val;
-    
-    while(1)
+    if (r == NULL)
     {
-    nextmin_fdepth=999999;
-    curnode = CreateNode(start);    
-    // create the first element of the search queue
-    if (head == NULL)
-    {
-        cursqelement = CreateSearchQueueElement(curnode);
-        head = cursqelement;
+        if (statsformat == STATS_CSV)
+            printf("# threads %d timelimit %.3f\n", searchsettings.threads, searchsettings.timelimit/1e9);
+        if (statsformat == STATS_CSV)
+            printf("algorithm,heuristic,instances,solved,over_budget,median_seconds,p95_seconds,median_expanded,p95_expanded\n");
+        else if (statsformat == STATS_TEXT)
+            printf("%-10s %-10s %9s %6s %11s %14s %14s %15s %15s\n", "algorithm", "heuristic", "instances", "solved",
+                   "over budget", "median s", "p95 s", "median expanded", "p95 expanded");
     }
+    else if (statsformat == STATS_CSV)
+        printf("%s,%s,%d,%d,%d,%.9f,%.9f,%lld,%lld\n", r->algorithm, r->heuristic, r->instances, r->solved,
+               r->over_budget, r->median_seconds, r->p95_seconds, r->median_expanded, r->p95_expanded);
+    else if (statsformat == STATS_JSON)
+        printf("{\"algorithm\": \"%s\", \"heuristic\": \"%s\", \"instances\": %d, \"solved\": %d, \"over_budget\": %d, "
+               "\"median_seconds\": %.9f, \"p95_seconds\": %.9f, \"median_expanded\": %lld, \"p95_expanded\": %lld}\n",
+               r->algorithm, r->heuristic, r->instances, r->solved, r->over_budget,
+               r->median_seconds, r->p95_seconds, r->median_expanded, r->p95_expanded);
+    else
+        printf("%-10s %-10s %9d %6d %11d %14.6f %14.6f %15lld %15lld\n", r->algorithm, r->heuristic, r->instances,
+               r->solved, r->over_budget, r->median_seconds, r->p95_seconds, r->median_expanded, r->p95_expanded);
+    fflush(stdout);
+}
 
-    temphead = head;    
-    while(temphead != NULL)
+// This function compares the rows of a benchmark with those of a baseline table in the
+// CSV format of PrintBenchResult. Fewer solved instances, more expansions or slower
+// times beyond the tolerances are reported on stderr.
+// Rows of the benchmark without a row in the baseline are reported but are not regressions.
+// returns the number of regressions, -1 if the baseline can not be read
+int CompareBaseline(const char *filename, const struct BenchResult *results, int count)
+{
+    FILE *fp;
+    char line[BATCH_LINE_LENGTH];
+    char matched[NALGORITHMS*NSEARCHHEURISTICS] = {0};
+    struct BenchResult base;
+    const struct BenchResult *r;
+    int i, regressions = 0;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL)
     {
-        ///////////////////////////////////////////////////////////////////////
-        nodes_expanded++;
-        ///////////////////////////////////////////////////////////////////////
-        head = head->next;
-//        printf("%p\n",head);
-        // check for goal
-        if (GoalTest(goal, temphead->nodeptr->layout) == 1)
+        perror(filename);
+        return(-1);
+    }
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        if (sscanf(line, "%15[^,],%15[^,],%d,%d,%d,%lf,%lf,%lld,%lld", base.algorithm, base.heuristic,
+                   &base.instances, &base.solved, &base.over_budget, &base.median_seconds, &base.p95_seconds,
+                   &base.median_expanded, &base.p95_expanded) != 9)
+            continue;
+        for (i=0, r=NULL; i<count && r==NULL; i++)
+            if (strcmp(results[i].algorithm, base.algorithm) == 0 && strcmp(results[i].heuristic, base.heuristic) == 0)
+                r = &results[i];
+        if (r == NULL)
+            continue;
+        matched[r-results] = 1;
+
+        if (r->solved < base.solved)
         {
-            // we have found a goal state!
-            printf("goal state found at depth: %d\n", temphead->nodeptr->g_val);
-            // path[0] - length of the path
-            // path[1:path[0]] - the moves in the path
-            path = (int *)malloc(sizeof(int));
-            path[0] = 0;
-            // traverse the path in the reverse order - from goal to root
-            // while traversing, store the blank tile moves for each step
-            curnode = temphead->nodeptr;
-            while (curnode->parent != NULL)
-            {
-                path = (int *)realloc(path, sizeof(int)*(path[0]+2));
-                path[path[0]+1] = curnode->move;
-                path[0]++;
-                curnode = curnode->parent;
-            }
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
-            return(path);
+            fprintf(stderr, "regression %s/%s: %d solved, baseline %d\n", r->algorithm, r->heuristic, r->solved, base.solved);
+            regressions++;
         }
-        FindBlankTile(temphead->nodeptr->layout, &blank);
-        // compute the children of the current node
-        for (i=0; i<MAXVALIDMOVES; i++)
+        if (r->median_expanded > base.median_expanded*BENCH_EXPANSION_TOLERANCE ||
+                r->p95_expanded > base.p95_expanded*BENCH_EXPANSION_TOLERANCE)
         {
-            if (IsValidMove(blank, i) == 1)
-            {
-                int lastmove = temphead->nodeptr->move;
-                if( (i==0 && lastmove==1) || (i==1 && lastmove==0) || (i==2 && lastmove==3) || (i==3 && lastmove==2) ) continue;
-                //////////////////////////////////////////////////////////////
-                nodes_generated++;
-                //////////////////////////////////////////////////////////////
-                curnode = CreateNode(temphead->nodeptr->layout);
-                MoveTile(curnode->layout, blank, i);
-                curnode->move = i;
-                curnode->g_val = temphead->nodeptr->g_val+1;
-                ////////////////////////////////////////////////////Computing max depth reached
-                if(max_depth < curnode->g_val){
-                    max_depth = curnode->g_val;
-                }
-                ////////////////////////////////////////////////////
-                curnode->h_val = HeuristicMisplacedTiles(goal,curnode->layout);
-                curnode->f_val = curnode->g_val + curnode->h_val;
-                if(curnode->f_val > fdepth){
-                    if(curnode->f_val < nextmin_fdepth){
-                        nextmin_fdepth = curnode->f_val;
-                    }
-                    continue;
-                }
-                curnode->parent = temphead->nodeptr;
-                cursqelement = CreateSearchQueueElement(curnode);
-                cursqelement->next = NULL;
-                InsertSearchQueueElementPriorityf(cursqelement);
-            }
+            fprintf(stderr, "regression %s/%s: median/p95 expanded %lld/%lld, baseline %lld/%lld\n", r->algorithm,
+                    r->heuristic, r->median_expanded, r->p95_expanded, base.median_expanded, base.p95_expanded);
+            regressions++;
         }
-        /////////////////////////////////////////////// Computing Memory consumed
-        if(memory_consumed < nodes_generated-nodes_expanded){
-            memory_consumed = nodes_generated-nodes_expanded;
+        if ((r->median_seconds > base.median_seconds*BENCH_TIME_TOLERANCE && r->median_seconds > base.median_seconds+BENCH_TIME_SLACK) ||
+                (r->p95_seconds > base.p95_seconds*BENCH_TIME_TOLERANCE && r->p95_seconds > base.p95_seconds+BENCH_TIME_SLACK))
+        {
+            fprintf(stderr, "regression %s/%s: median/p95 seconds %f/%f, baseline %f/%f\n", r->algorithm,
+                    r->heuristic, r->median_seconds, r->p95_seconds, base.median_seconds, base.p95_seconds);
+            regressions++;
         }
-        ///////////////////////////////////////////////
-        struct SearchQueueElement* temp;
-        temp = temphead;
-        temphead = head;
-        free(temp);
     }
-    
-    ////////////////////////////////////////////////////////////////////////
-    totalnodes_expanded += nodes_expanded;
-    totalnodes_generated += nodes_generated;
-    nodes_expanded=nodes_generated=0;
-    ////////////////////////////////////////////////////////////////////////
-    
-    fdepth = nextmin_fdepth;
-        
+    fclose(fp);
+    for (i=0; i<count; i++)
+        if (!matched[i])
+            fprintf(stderr, "no baseline for %s/%s\n", results[i].algorithm, results[i].heuristic);
+    return(regressions);
+}
+
+// This function reads the threads and time limit a baseline table was run with and uses
+// them for the benchmark, the times of the parallel algorithms and the instances that
+// run out of time are only comparable under the same settings. A baseline without them
+// leaves the settings as they are.
+// returns 1 on success, 0 if the baseline can not be read
+int PinBaselineSettings(const char *filename)
+{
+    FILE *fp;
+    char line[BATCH_LINE_LENGTH];
+    int threads;
+    double seconds;
+    uint64_t timelimit;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL)
+    {
+        perror(filename);
+        return(0);
     }
-            /////////////////////////////////////////// Printing parameters
-            end_time = clock();
-            computation_time = end_time - start_time;
-    
-            printf("Nodes Expanded : %d\n",nodes_expanded);
-            printf("Nodes Generated : %d\n",nodes_generated); 
-            printf("Max Depth Reached : %d\n", max_depth);
-            printf("Memory Consumed : %d\n", memory_consumed);
-            printf("Computation Time : %f\n",computation_time);
-            ////////////////////////////////////////////////////////////////////
-    return(path);
+    if (fgets(line, sizeof(line), fp) != NULL && sscanf(line, "# threads %d timelimit %lf", &threads, &seconds) == 2)
+    {
+        timelimit = (uint64_t)(seconds*1e9 + 0.5);
+        if (threads != searchsettings.threads || timelimit != searchsettings.timelimit)
+            fprintf(stderr, "running with %d threads and a time limit of %.3f s as in %s\n", threads, seconds, filename);
+        searchsettings.threads = threads;
+        searchsettings.timelimit = timelimit;
+    }
+    fclose(fp);
+    return(1);
 }
 
-// This function creates a node variable. Copies the contents of the layout of the node,
-// computes the heuristic values
-struct Node *CreateNode(int **a)
+// This function writes all of text to a file descriptor
+// returns 0 if the other end is gone
+int WriteAll(int fd, const char *text, size_t length)
 {
-    int i, j;
-    struct Node *curnode;
+    ssize_t written;
 
-    curnode = (struct Node *)malloc(sizeof(struct Node));
-    curnode->layout = (int **)malloc(sizeof(int*)*N);
-    for (i=0; i<N; i++)
+    while (length > 0)
     {
-        curnode->layout[i] = (int *)malloc(sizeof(int)*N);
-        for (j=0; j<N; j++)
-            curnode->layout[i][j] = a[i][j];
+        written = write(fd, text, length);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return(0);
+        text += written;
+        length -= (size_t)written;
     }
-    curnode->parent = NULL;
-    curnode->g_val = 0;
-    curnode->h_val = HeuristicMisplacedTiles(goal,curnode->layout);
-    curnode->f_val = curnode->g_val + curnode->h_val;
-    curnode->move = -1;
+    return(1);
+}
 
-    return(curnode);
+// This function sends a reply line to a client, whole even if several workers reply at once
+void WriteReply(struct ServerConnection *c, const char *text)
+{
+    pthread_mutex_lock(&c->writelock);
+    WriteAll(c->outfd, text, strlen(text));
+    pthread_mutex_unlock(&c->writelock);
 }
 
-// This function creates a search queue element
-struct SearchQueueElement *CreateSearchQueueElement(struct Node *curnode)
+// This function closes a connection once it has no more lines and no pending requests.
+// It is called with the lock of the server held
+void ReleaseConnection(struct ServerConnection *c)
 {
-    struct SearchQueueElement *cursqelement;
+    close(c->infd);
+    if (c->outfd != c->infd)
+        close(c->outfd);
+    pthread_mutex_destroy(&c->writelock);
+    free(c);
+}
 
-    cursqelement = (struct SearchQueueElement*)malloc(sizeof(struct SearchQueueElement));
-    cursqelement->nodeptr = curnode;
-    cursqelement->next = NULL;
+// This function writes the counters of the server into text: the requests answered, those
+// solved, and the median and 99th percentile of the latency over the latest requests
+void ServerStatistics(struct Server *s, char *text, size_t size)
+{
+    double *sorted;
+    long long answered, solved;
+    int n;
 
-    return(cursqelement);
+    sorted = (double *)malloc(sizeof(double)*SERVER_LATENCY_SAMPLES);
+    pthread_mutex_lock(&s->lock);
+    answered = s->answered;
+    solved = s->solved;
+    n = answered < SERVER_LATENCY_SAMPLES ? (int)answered : SERVER_LATENCY_SAMPLES;
+    memcpy(sorted, s->latencies, sizeof(double)*n);
+    pthread_mutex_unlock(&s->lock);
 
+    qsort(sorted, n, sizeof(double), CompareDoubles);
+    snprintf(text, size, "stats answered %lld solved %lld p50 %f p99 %f\n", answered, solved,
+             n > 0 ? sorted[PercentileIndex(n, 50)] : 0.0, n > 0 ? sorted[PercentileIndex(n, 99)] : 0.0);
+    free(sorted);
 }
 
-// This function appends a search queue element to the end of the queue - for breadth first search
-void AppendSearchQueueElementToEnd(struct SearchQueueElement* cursqelement)
+// This function answers one request with the solver of a worker. A request line holds the
+// tiles of the start state, before them it may give -id n, -a algorithm, -heuristic name
+// and -timelimit s for this request alone. The reply is "id moves expanded seconds path"
+// with the moves of the blank as l, r, u and d, or "id unsolved expanded seconds",
+// "id unsolvable" or "id invalid" as in batch mode.
+// returns the status of the solve
+int AnswerRequest(struct Server *s, struct P1Solver *solver, struct ServerRequest *r)
 {
-    struct SearchQueueElement *tempsqelement;
-    if (head != NULL)
+    struct P1Limits limits;
+    struct P1Result result;
+    const char *algorithm = AlgorithmNames[s->algorithm];
+    char *token, *rest, *end, *reply;
+    int i, count = 0, tiles[NTILES];
+    size_t length;
+
+    limits.seconds = s->settings.timelimit*1e-9;
+    limits.megabytes = s->settings.memorylimit/(double)(1<<20);
+    limits.nodes = s->settings.nodebudget;
+    limits.threads = 1;     // the workers solve requests side by side
+    limits.heuristic = HeuristicNames[s->settings.heuristic];
+
+    result.status = P1_INVALID;
+    for (token=strtok_r(r->line, " ,\t\r", &rest); token!=NULL; token=strtok_r(NULL, " ,\t\r", &rest))
+    {
+        if (token[0] == '-' && (token[1] < '0' || token[1] > '9'))
+        {
+            end = strtok_r(NULL, " ,\t\r", &rest);
+            if (end == NULL)
+                count = -1;
+            else if (strcmp(token, "-id") == 0)
+                r->id = atoll(end);
+            else if (strcmp(token, "-a") == 0)
+                algorithm = end;
+            else if (strcmp(token, "-heuristic") == 0)
+                limits.heuristic = end;
+            else if (strcmp(token, "-timelimit") == 0)
+                limits.seconds = atof(end);
+            else
+                count = -1;
+        }
+        else if (count >= 0 && count < NTILES)
+        {
+            tiles[count] = (int)strtol(token, &end, 10);
+            count = (*end == '\0') ? count+1 : -1;
+        }
+        else
+            count = -1;
+        if (count < 0)
+            break;
+    }
+    if (count == NTILES)
+        result = P1Solve(solver, tiles, NULL, algorithm, &limits);
+
+    length = 128 + (result.status == P1_SOLVED ? result.length : 0);
+    reply = (char *)malloc(length);
+    if (result.status == P1_SOLVED)
     {
-        tempsqelement = head;
-        while (tempsqelement->next != NULL)
-            tempsqelement = tempsqelement->next;
-        tempsqelement->next = cursqelement;
+        i = snprintf(reply, length, "%lld %d %lld %f ", r->id, result.length, result.nodes_expanded, result.seconds);
+        for (count=0; count<result.length; count++)
+            reply[i++] = "lrud"[result.moves[count]];
+        if (result.length == 0)
+            reply[i++] = '-';
+        reply[i++] = '\n';
+        reply[i] = '\0';
     }
+    else if (result.status == P1_UNSOLVABLE)
+        snprintf(reply, length, "%lld unsolvable\n", r->id);
+    else if (result.status == P1_INVALID)
+        snprintf(reply, length, "%lld invalid\n", r->id);
     else
-        head = cursqelement;
-    return;
+        snprintf(reply, length, "%lld unsolved %lld %f\n", r->id, result.nodes_expanded, result.seconds);
+    WriteReply(r->connection, reply);
+    free(reply);
+    return(result.status);
 }
 
-
-// This function appends a search queue element to the front of the queue - for Depth first search
-void AppendSearchQueueElementToFront(struct SearchQueueElement* cursqelement)
+// This function is the body of every worker of the server. It takes the oldest queued
+// request until the server stops and the queue is empty. The solver of the worker keeps
+// its arenas, tables and open lists from one request to the next
+void *ServerWorker(void *arg)
 {
-    if (head != NULL)
+    struct Server *s = (struct Server *)arg;
+    struct ServerRequest *r;
+    struct P1Solver *solver;
+    int status;
+
+    solver = P1CreateSolver(s->pdbfile);
+    if (solver == NULL)
+        return(NULL);
+    solver->context.searchsettings = s->settings;
+    for (;;)
     {
-        cursqelement->next = head;
-        head = cursqelement;
+        pthread_mutex_lock(&s->lock);
+        while (s->first == NULL && s->stopping == 0)
+            pthread_cond_wait(&s->ready, &s->lock);
+        r = s->first;
+        if (r != NULL)
+        {
+            s->first = r->next;
+            if (s->first == NULL)
+                s->last = NULL;
+        }
+        pthread_mutex_unlock(&s->lock);
+        if (r == NULL)
+            break;
+
+        status = AnswerRequest(s, solver, r);
+
+        pthread_mutex_lock(&s->lock);
+        s->latencies[s->answered % SERVER_LATENCY_SAMPLES] = (NowNanoseconds() - r->arrival)*1e-9;
+        s->answered++;
+        if (status == P1_SOLVED)
+            s->solved++;
+        r->connection->pending--;
+        if (r->connection->pending == 0 && r->connection->closed)
+            ReleaseConnection(r->connection);
+        pthread_mutex_unlock(&s->lock);
+        free(r);
     }
-    else
-        head = cursqelement;
-    return;
+    P1DestroySolver(solver);
+    return(NULL);
 }
 
-// This function appends a search queue element to the front of the queue - for Greedy best first search
-void InsertSearchQueueElementPriorityh(struct SearchQueueElement* cursqelement)
+// This function reads what a client has sent and queues its complete request lines. All
+// lines of one read go to the workers at once, a client that sends many requests without
+// waiting for the replies has them solved side by side. Empty lines and lines starting
+// with # are skipped, the line "stats" is answered right away with the counters of the server,
+// and so is a line longer than the buffer, as invalid.
+// returns 0 once the client closes the connection or sends "quit"
+int ReadRequests(struct Server *s, struct ServerConnection *c)
 {
-    int h_val = cursqelement->nodeptr->h_val;
-    struct SearchQueueElement *tempsqelement;
-    if (head != NULL)
+    struct ServerRequest *first = NULL, *last = NULL, *r;
+    char *line, *newline;
+    char text[BATCH_LINE_LENGTH];
+    ssize_t n;
+    int pending = 0, open = 1;
+
+    n = read(c->infd, c->buffer + c->length, BATCH_LINE_LENGTH - c->length);
+    if (n < 0 && errno == EINTR)
+        return(1);
+    if (n > 0)
+        c->length += (int)n;
+    else
     {
-        if(head->nodeptr->h_val > h_val){
-            cursqelement->next = head;
-            head = cursqelement;
-        }
-        else{
-            tempsqelement = head;
-            if(head->next == NULL){
-                head->next = cursqelement;
-            }
-            else{
-                while (tempsqelement->next != NULL && tempsqelement->next->nodeptr->h_val < h_val)
-                    tempsqelement = tempsqelement->next;
-        
-                cursqelement->next = tempsqelement->next;
-                tempsqelement->next = cursqelement;
+        // the last line may end without a newline
+        open = 0;
+        if ((c->length > 0 || c->overlong) && c->length < BATCH_LINE_LENGTH)
+            c->buffer[c->length++] = '\n';
+    }
+    c->buffer[c->length] = '\0';
+
+    line = c->buffer;
+    while ((newline = strchr(line, '\n')) != NULL)
+    {
+        *newline = '\0';
+        if (newline > line && newline[-1] == '\r')
+            newline[-1] = '\0';
+        c->lines++;
+        if (c->overlong)
+        {
+            if (c->overlong == 1)
+            {
+                snprintf(text, sizeof(text), "%lld invalid\n", c->lines);
+                WriteReply(c, text);
             }
+            c->overlong = 0;
         }
+        else if (strcmp(line, "quit") == 0)
+        {
+            open = 0;
+            break;
+        }
+        else if (strcmp(line, "stats") == 0)
+        {
+            ServerStatistics(s, text, sizeof(text));
+            WriteReply(c, text);
+        }
+        else if (line[strspn(line, " \t")] != '\0' && line[strspn(line, " \t")] != '#')
+        {
+            r = (struct ServerRequest *)malloc(sizeof(struct ServerRequest));
+            r->connection = c;
+            r->id = c->lines;
+            r->arrival = NowNanoseconds();
+            strcpy(r->line, line);
+            r->next = NULL;
+            if (last != NULL)
+                last->next = r;
+            else
+                first = r;
+            last = r;
+            pending++;
+        }
+        line = newline+1;
     }
-    else
-        head = cursqelement;
-    return;
+    // a line that fills the buffer can not be a request, it is dropped up to its end
+    if (line == c->buffer && c->length == BATCH_LINE_LENGTH)
+    {
+        if (c->overlong == 0)
+            c->overlong = (line[strspn(line, " \t")] == '#') ? 2 : 1;
+        line = c->buffer + c->length;
+    }
+    c->length -= (int)(line - c->buffer);
+    memmove(c->buffer, line, c->length);
+
+    pthread_mutex_lock(&s->lock);
+    if (first != NULL)
+    {
+        if (s->last != NULL)
+            s->last->next = first;
+        else
+            s->first = first;
+        s->last = last;
+        c->pending += pending;
+        pthread_cond_broadcast(&s->ready);
+    }
+    if (open == 0)
+    {
+        c->closed = 1;
+        if (c->pending == 0)
+            ReleaseConnection(c);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return(open);
 }
 
-void InsertSearchQueueElementPriorityf(struct SearchQueueElement* cursqelement)
+// This function adds a client to the server
+// returns NULL if the server has as many clients as it can read from
+struct ServerConnection *OpenConnection(struct ServerConnection **connections, int *count, int infd, int outfd)
 {
-    int f_val = cursqelement->nodeptr->f_val;
-    struct SearchQueueElement *tempsqelement;
-    if (head != NULL)
+    struct ServerConnection *c;
+
+    if (*count == SERVER_CONNECTIONS)
+        return(NULL);
+    c = (struct ServerConnection *)calloc(1, sizeof(struct ServerConnection));
+    c->infd = infd;
+    c->outfd = outfd;
+    pthread_mutex_init(&c->writelock, NULL);
+    connections[(*count)++] = c;
+    return(c);
+}
+
+// This function ends the main loop of the server on SIGINT and SIGTERM
+void StopServer(int signal)
+{
+    (void)signal;
+    serverstop = 1;
+}
+
+// This function serves requests until it is stopped by SIGINT or SIGTERM, on the Unix socket
+// socketname, or until the end of the standard input if socketname is "-". The requests of
+// all clients share one queue that nthreads workers take them from, each with a solver of
+// its own that keeps the heuristic tables and the search memory warm between requests.
+// returns the exit status of the program
+int Serve(const char *socketname, int algorithm, int nthreads, const char *pdbfile)
+{
+    struct Server s;
+    struct ServerConnection *connections[SERVER_CONNECTIONS];
+    struct pollfd fds[SERVER_CONNECTIONS+1];
+    struct sockaddr_un address;
+    struct sigaction action;
+    pthread_t *threads;
+    char text[BATCH_LINE_LENGTH];
+    int i, n, fd, started, count = 0, listener = -1;
+
+    memset(&s, 0, sizeof(s));
+    s.pdbfile = pdbfile;
+    s.algorithm = algorithm;
+    s.settings = searchsettings;
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.ready, NULL);
+    // the tables that every solver shares are built before the first request
+    if (s.settings.heuristic >= HEURISTIC_LINEAR)
+        pthread_once(&linetablesonce, BuildLineTables);
+
+    if (strcmp(socketname, "-") == 0)
+        OpenConnection(connections, &count, 0, 1);
+    else
     {
-        if(head->nodeptr->f_val > f_val){
-            cursqelement->next = head;
-            head = cursqelement;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(socketname) >= sizeof(address.sun_path))
+        {
+            fprintf(stderr, "socket name %s is too long\n", socketname);
+            return(1);
         }
-        else{
-            tempsqelement = head;
-            if(head->next == NULL){
-                head->next = cursqelement;
-            }
-            else{
-                while (tempsqelement->next != NULL && tempsqelement->next->nodeptr->f_val < f_val)
-                    tempsqelement = tempsqelement->next;
-        
-                cursqelement->next = tempsqelement->next;
-                tempsqelement->next = cursqelement;
-            }
+        strcpy(address.sun_path, socketname);
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(socketname);
+        if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+                listen(listener, SOMAXCONN) != 0)
+        {
+            perror(socketname);
+            if (listener >= 0)
+                close(listener);
+            return(1);
         }
     }
-    else
-        head = cursqelement;
-    return;
-}
 
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = StopServer;     // without SA_RESTART, poll returns at once
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);           // a client that leaves early only loses its replies
 
-void FreeSearchMemory()
+    if (nthreads < 1)
+        nthreads = 1;
+    threads = (pthread_t *)malloc(sizeof(pthread_t)*nthreads);
+    for (started=0; started<nthreads; started++)
+        if (pthread_create(&threads[started], NULL, ServerWorker, &s) != 0)
+            break;
+    if (started == 0)
+    {
+        fprintf(stderr, "no worker thread could be started\n");
+        return(1);
+    }
+    if (listener >= 0)
+        fprintf(stderr, "serving on %s with %d threads\n", socketname, started);
+
+    while (serverstop == 0 && (listener >= 0 || count > 0))
+    {
+        n = count;
+        for (i=0; i<n; i++)
+        {
+            fds[i].fd = connections[i]->infd;
+            fds[i].events = POLLIN;
+        }
+        fds[n].fd = listener;
+        fds[n].events = POLLIN;
+        if (poll(fds, n + (listener >= 0), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("poll");
+            break;
+        }
+        // the connections that close are replaced by the last ones
+        for (i=n-1; i>=0; i--)
+            if (fds[i].revents != 0 && ReadRequests(&s, connections[i]) == 0)
+                connections[i] = connections[--count];
+        if (listener >= 0 && (fds[n].revents & POLLIN))
+        {
+            fd = accept(listener, NULL, NULL);
+            if (fd >= 0 && OpenConnection(connections, &count, fd, fd) == NULL)
+                close(fd);
+        }
+    }
+
+    // the queued requests are still answered, then the workers end
+    pthread_mutex_lock(&s.lock);
+    s.stopping = 1;
+    pthread_cond_broadcast(&s.ready);
+    pthread_mutex_unlock(&s.lock);
+    for (i=0; i<started; i++)
+        pthread_join(threads[i], NULL);
+    for (i=0; i<count; i++)
+        ReleaseConnection(connections[i]);
+
+    ServerStatistics(&s, text, sizeof(text));
+    fprintf(stderr, "%s", text);
+    if (listener >= 0)
+    {
+        close(listener);
+        unlink(socketname);
+    }
+    pthread_cond_destroy(&s.ready);
+    pthread_mutex_destroy(&s.lock);
+    free(threads);
+    return(0);
+}
+
+// This function runs the benchmark: every algorithm with every heuristic it can use (or
+// only algorithm and heuristic, where they are not -1) over all instances of the batch,
+// and prints a table of the median and 95th percentile of the times and expansions.
+// returns the exit status of the program, 2 if there are regressions against the baseline
+int RunBenchmark(struct Batch *b, State goal, int algorithm, int heuristic, const char *baseline)
 {
-    int i;
-    struct SearchQueueElement *cursqelement, *tempsqelement;
-    struct Node *curnode;
+    struct BenchResult results[NALGORITHMS*NSEARCHHEURISTICS];
+    int a, h, count = 0, regressions = 0;
+    int restore = searchsettings.heuristic;
+
+    if (baseline != NULL && !PinBaselineSettings(baseline))
+        return(1);
+    searchverbose = 0;
+    PrintBenchResult(NULL);
+    for (a=0; a<NALGORITHMS; a++)
+    {
+        if (algorithm >= 0 && a != algorithm)
+            continue;
+        if (a == ALGORITHM_ORACLE && distanceoracle.table == NULL)
+            continue;
+        if (a == ALGORITHM_BFS || a == ALGORITHM_DFS || a == ALGORITHM_GBEFS || a == ALGORITHM_ORACLE || a == ALGORITHM_BIBFS ||
+                a == ALGORITHM_EXTBFS || a == ALGORITHM_IDDFS)
+        {
+            BenchmarkCombination(b, goal, a, -1, &results[count]);
+            PrintBenchResult(&results[count++]);
+            continue;
+        }
+        for (h=0; h<NSEARCHHEURISTICS; h++)
+        {
+            if ((heuristic >= 0 && h != heuristic) || (h == HEURISTIC_PDB && htables.pdbs == NULL) ||
+                    (h == HEURISTIC_WALKING && N > 4))
+                continue;
+            BenchmarkCombination(b, goal, a, h, &results[count]);
+            PrintBenchResult(&results[count++]);
+        }
+    }
+    searchsettings.heuristic = restore;
 
-    cursqelement = head;
-    while (cursqelement != NULL)
+    if (baseline != NULL)
     {
-        tempsqelement = cursqelement;
-        cursqelement = cursqelement->next;
-        curnode = tempsqelement->nodeptr;
-        free(tempsqelement);
-        for (i=0; i<N; i++)
-            free(curnode->layout[i]);
-        free(curnode->layout);
-        free(curnode);
+        regressions = CompareBaseline(baseline, results, count);
+        if (regressions < 0)
+            return(1);
+        fprintf(stderr, "%d regressions against %s\n", regressions, baseline);
     }
-    head = NULL;
+    return(regressions > 0 ? 2 : 0);
 }
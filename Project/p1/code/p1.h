@@ -0,0 +1,70 @@
+/**
+* Library interface of the puzzle solver in p1.c
+* Build p1.c with -DP1_LIBRARY to leave out main, and with the same -DN as the program
+* that links it: boards are N*N tiles in row major order with 0 for the blank.
+* A solver holds the memory, tables and statistics of the searches run with it. Every
+* thread solves with a solver of its own, then any number of solves run at the same
+* time without locks and nothing is printed.
+*/
+
+#ifndef P1_H
+#define P1_H
+
+#include <stddef.h>
+
+#define P1_SOLVED 0         // status of a result
+#define P1_UNSOLVABLE 1     // the start can not reach the goal
+#define P1_OVER_BUDGET 2    // the time, memory or node limit ran out before a solution was found
+#define P1_NOT_FOUND 3      // the search ended without a solution, like dfs at its depth limit
+#define P1_INVALID 4        // unknown or NULL algorithm or heuristic, a heuristic or algorithm whose tables
+                            // are not loaded, or tiles that do not make up a board
+#define P1_ERROR 5          // memory or threads ran out, or the layer files of extbfs could not be read or written
+#define P1_MAX_INCUMBENTS 16    // solutions of arastar a result keeps, the first ones and the last
+
+struct P1Solver;            // opaque, see P1CreateSolver
+
+// limits of one solve, zero for no limit or the default
+struct P1Limits
+{
+    double seconds;         // time the search may take
+    double megabytes;       // memory the search structures may hold
+    int nodes;              // nodes smastar may keep
+    int threads;            // threads of hdastar and pidastar, 1 by default
+    const char *heuristic;  // name as for -heuristic, manhattan by default
+};
+
+// a solution arastar found on its way to the shortest one
+struct P1Incumbent
+{
+    int length;
+    double bound;           // the solution is at most this many times as long as the shortest one
+    long long nodes_expanded;   // nodes expanded when it was found
+    double seconds;
+};
+
+// result of one solve
+struct P1Result
+{
+    int status;
+    int length;             // number of moves, -1 without a solution
+    const int *moves;       // moves of the blank, first move first: 0 left, 1 right, 2 up,
+                            // 3 down. Owned by the solver, valid until its next solve
+    long long nodes_expanded;
+    long long nodes_generated;
+    size_t peak_bytes;      // memory the search structures grew by, not what they kept from earlier solves
+    double seconds;
+    const struct P1Incumbent *incumbents;   // solutions of arastar, longest first, with the bound of
+                                            // each as tight as it got. Owned by the solver like moves
+    int nincumbents;
+};
+
+// pdbfile may be NULL, returns NULL if it can not be loaded or memory runs out. Solvers
+// have no way to load the distance oracle, algorithm "oracle" gives P1_INVALID (only the
+// server of the program, which loads it with -oracle, can answer from it)
+struct P1Solver *P1CreateSolver(const char *pdbfile);
+void P1DestroySolver(struct P1Solver *solver);
+// algorithm is a name as for -a, goal may be NULL for the goal of the program
+struct P1Result P1Solve(struct P1Solver *solver, const int *start, const int *goal, const char *algorithm,
+                        const struct P1Limits *limits);
+
+#endif
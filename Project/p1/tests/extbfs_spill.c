@@ -0,0 +1,81 @@
+/**
+* Runs extbfs with its files in a fresh directory and a limit on the size of the files
+* a process may write, which makes a write fail in the middle of a layer: once while a
+* run is written and once while the runs are merged into the layer file. Each solve must
+* come back with P1_ERROR and leave the directory empty.
+* Build: gcc -DN=3 -DP1_LIBRARY -o extbfs_spill extbfs_spill.c -lpthread -lm
+*/
+
+#include "../code/p1.c"
+#include <dirent.h>
+#include <sys/resource.h>
+
+#define FILE_LIMIT (16 << 10)   // bytes a file may grow to, a few layers of the 8-puzzle fit
+
+// This function returns the number of entries of a directory besides . and .., -1 if it can not be read
+int CountEntries(const char *name)
+{
+    DIR *dir = opendir(name);
+    struct dirent *entry;
+    int count = 0;
+
+    if (dir == NULL)
+        return(-1);
+    while ((entry = readdir(dir)) != NULL)
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+            count++;
+    closedir(dir);
+    return(count);
+}
+
+int main()
+{
+    struct P1Solver *solver;
+    struct P1Limits limits;
+    struct P1Result result;
+    struct rlimit limit, unlimited;
+    int start[NTILES] = {8, 6, 7, 2, 5, 4, 3, 0, 1};
+    double megabytes[2] = {1, 0.01};    // runs larger than the limit, then runs that fit
+    int i, entries, failures = 0;
+    char directory[] = "/tmp/p1-spill-XXXXXX";
+
+    solver = P1CreateSolver(NULL);
+    if (solver == NULL || mkdtemp(directory) == NULL)
+    {
+        printf("FAIL: no solver or directory\n");
+        return(1);
+    }
+    setenv("TMPDIR", directory, 1);
+    // a write beyond the limit fails with EFBIG instead of ending the process
+    signal(SIGXFSZ, SIG_IGN);
+    getrlimit(RLIMIT_FSIZE, &unlimited);
+    limit = unlimited;
+    limit.rlim_cur = FILE_LIMIT;
+
+    memset(&limits, 0, sizeof(limits));
+    for (i=0; i<2; i++)
+    {
+        limits.megabytes = megabytes[i];
+        setrlimit(RLIMIT_FSIZE, &limit);
+        result = P1Solve(solver, start, NULL, "extbfs", &limits);
+        setrlimit(RLIMIT_FSIZE, &unlimited);
+        entries = CountEntries(directory);
+        if (result.status != P1_ERROR || entries != 0)
+        {
+            printf("FAIL: runs of %g MB: status %d, %d files left behind\n", megabytes[i], result.status, entries);
+            failures++;
+        }
+    }
+
+    // without the limit the same search gets through
+    result = P1Solve(solver, start, NULL, "extbfs", &limits);
+    if (result.status != P1_SOLVED || result.length != 31 || CountEntries(directory) != 0)
+    {
+        printf("FAIL: extbfs does not work after a write error\n");
+        failures++;
+    }
+    P1DestroySolver(solver);
+    rmdir(directory);
+    printf("%s: extbfs cleaned up after failed writes\n", failures ? "FAIL" : "PASS");
+    return(failures ? 1 : 0);
+}
@@ -0,0 +1,53 @@
+/**
+* Solves an 8-puzzle instance with arastar through the library and checks the incumbents
+* of the result: each shorter than the one before, bounds of at least 1, and the last one
+* the returned solution, proven shortest.
+* Build: gcc -DN=3 -DP1_LIBRARY -o library_arastar library_arastar.c -lpthread -lm
+*/
+
+#include "../code/p1.c"
+
+int main()
+{
+    struct P1Solver *solver;
+    struct P1Result result;
+    int start[NTILES] = {8, 6, 7, 2, 5, 4, 3, 0, 1};
+    int i, failures = 0;
+
+    solver = P1CreateSolver(NULL);
+    if (solver == NULL)
+    {
+        printf("FAIL: no solver\n");
+        return(1);
+    }
+    result = P1Solve(solver, start, NULL, "arastar", NULL);
+    if (result.status != P1_SOLVED || result.nincumbents < 2)
+    {
+        printf("FAIL: status %d with %d incumbents\n", result.status, result.nincumbents);
+        failures++;
+    }
+    for (i=0; i<result.nincumbents; i++)
+        if (result.incumbents[i].bound < 1 || (i > 0 && (result.incumbents[i].length >= result.incumbents[i-1].length ||
+                result.incumbents[i].nodes_expanded < result.incumbents[i-1].nodes_expanded)))
+        {
+            printf("FAIL: incumbent %d: %d moves, bound %f\n", i, result.incumbents[i].length, result.incumbents[i].bound);
+            failures++;
+        }
+    if (result.nincumbents > 0 && (result.incumbents[result.nincumbents-1].length != result.length ||
+            result.incumbents[result.nincumbents-1].bound != 1))
+    {
+        printf("FAIL: the last incumbent is not the shortest solution\n");
+        failures++;
+    }
+
+    // other algorithms have none
+    result = P1Solve(solver, start, NULL, "astar", NULL);
+    if (result.nincumbents != 0)
+    {
+        printf("FAIL: astar reports incumbents\n");
+        failures++;
+    }
+    P1DestroySolver(solver);
+    printf("%s: arastar reports its incumbents\n", failures ? "FAIL" : "PASS");
+    return(failures ? 1 : 0);
+}
@@ -0,0 +1,94 @@
+/**
+* Runs every algorithm of the library with little more address space than the process
+* already has. Each solve must come back as solved or with P1_ERROR, without printing
+* anything and without ending the process, and the solver must work again afterwards.
+* Build: gcc -DN=3 -DP1_LIBRARY -o library_oom library_oom.c -lpthread -lm
+*/
+
+#include "../code/p1.c"
+#include <sys/resource.h>
+
+#define SPARE_BYTES (4 << 20)    // address space left to the searches
+
+int main()
+{
+    struct P1Solver *solver;
+    struct P1Limits limits;
+    struct P1Result result;
+    struct rlimit limit, unlimited;
+    int start[NTILES] = {8, 6, 7, 2, 5, 4, 3, 0, 1};
+    int i, failures = 0, errors = 0;
+    long pages = 0;
+    char output[] = "/tmp/p1-oom-XXXXXX";
+    int fd, saved, savederr;
+    FILE *fp;
+
+    solver = P1CreateSolver(NULL);
+    fd = mkstemp(output);
+    if (solver == NULL || fd < 0)
+    {
+        printf("FAIL: no solver\n");
+        return(1);
+    }
+    memset(&limits, 0, sizeof(limits));
+    limits.threads = 2;
+    limits.nodes = 1 << 20;
+    limits.heuristic = "misplaced";
+
+    // everything the library prints would go to the file
+    fflush(stdout);
+    saved = dup(1);
+    savederr = dup(2);
+    dup2(fd, 1);
+    dup2(fd, 2);
+    fp = fopen("/proc/self/statm", "r");
+    if (fp == NULL || fscanf(fp, "%ld", &pages) != 1)
+        pages = 0;
+    if (fp != NULL)
+        fclose(fp);
+    getrlimit(RLIMIT_AS, &unlimited);
+    limit = unlimited;
+    limit.rlim_cur = (rlim_t)pages*sysconf(_SC_PAGESIZE) + SPARE_BYTES;
+    setrlimit(RLIMIT_AS, &limit);
+
+    for (i=0; i<NALGORITHMS; i++)
+    {
+        if (i == ALGORITHM_ORACLE)
+            continue;
+        result = P1Solve(solver, start, NULL, AlgorithmNames[i], &limits);
+        if (result.status == P1_ERROR)
+            errors++;
+        else if (result.status != P1_SOLVED && result.status != P1_NOT_FOUND)
+        {
+            dprintf(saved, "FAIL: %s: status %d\n", AlgorithmNames[i], result.status);
+            failures++;
+        }
+    }
+
+    setrlimit(RLIMIT_AS, &unlimited);
+    fflush(stdout);
+    dup2(saved, 1);
+    dup2(savederr, 2);
+    if (lseek(fd, 0, SEEK_END) != 0)
+    {
+        printf("FAIL: the library printed while memory ran out\n");
+        failures++;
+    }
+    close(fd);
+    unlink(output);
+    if (errors == 0)
+    {
+        printf("FAIL: no search ran out of memory\n");
+        failures++;
+    }
+
+    result = P1Solve(solver, start, NULL, "astar", &limits);
+    if (result.status != P1_SOLVED || result.length != 31)
+    {
+        printf("FAIL: the solver does not work after running out of memory\n");
+        failures++;
+    }
+    P1DestroySolver(solver);
+    printf("%s: %d of %d algorithms ran out of memory\n", failures ? "FAIL" : "PASS", errors, NALGORITHMS-1);
+    return(failures ? 1 : 0);
+}
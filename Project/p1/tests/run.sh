@@ -0,0 +1,18 @@
+#!/bin/sh
+# Builds and runs the tests of p1.c. Usage: tests/run.sh [build directory]
+# Every test includes p1.c built as a library and exits 0 when it passes.
+
+here=$(cd "$(dirname "$0")" && pwd)
+build=${1:-${TMPDIR:-/tmp}/p1-tests}
+mkdir -p "$build" || exit 1
+status=0
+
+for test in server_arena library_oom extbfs_spill library_arastar; do
+    if ! gcc -O2 -Wall -Wextra -DN=3 -DP1_LIBRARY -o "$build/$test" "$here/$test.c" -lpthread -lm; then
+        echo "FAIL: $test does not build"
+        status=1
+    elif ! "$build/$test"; then
+        status=1
+    fi
+done
+exit $status
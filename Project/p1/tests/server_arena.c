@@ -0,0 +1,70 @@
+/**
+* Checks that a server worker keeps its arena from one request to the next: the bytes the
+* arena got from malloc stay the same over repeated requests instead of being given back
+* and requested again for every one.
+* Build: gcc -DN=3 -DP1_LIBRARY -o server_arena server_arena.c -lpthread -lm
+*/
+
+#include "../code/p1.c"
+
+#define REQUESTS 50
+
+int main()
+{
+    struct Server s;
+    struct ServerConnection c;
+    struct ServerRequest r;
+    struct P1Solver *solver;
+    struct SearchSettings defaults = DEFAULT_SEARCH_SETTINGS;
+    size_t reserved = 0;
+    int i, failures = 0;
+
+    memset(&s, 0, sizeof(s));
+    s.algorithm = ALGORITHM_ASTAR;
+    s.settings = defaults;
+    s.settings.heuristic = HEURISTIC_MANHATTAN;
+    memset(&c, 0, sizeof(c));
+    c.infd = -1;
+    c.outfd = open("/dev/null", O_WRONLY);
+    pthread_mutex_init(&c.writelock, NULL);
+
+    solver = P1CreateSolver(NULL);
+    if (solver == NULL || c.outfd < 0)
+    {
+        printf("FAIL: no solver\n");
+        return(1);
+    }
+    solver->context.searchsettings = s.settings;
+    for (i=0; i<REQUESTS; i++)
+    {
+        memset(&r, 0, sizeof(r));
+        r.connection = &c;
+        r.id = i+1;
+        // 31 moves, the longest of the 8-puzzle, with a few thousand nodes in the arena
+        strcpy(r.line, "8 6 7 2 5 4 3 0 1");
+        if (AnswerRequest(&s, solver, &r) != P1_SOLVED)
+        {
+            printf("FAIL: request %d not solved\n", i+1);
+            failures++;
+        }
+        if (i == 0)
+            reserved = solver->context.arena.bytesreserved;
+        else if (solver->context.arena.bytesreserved != reserved)
+        {
+            printf("FAIL: request %d: arena holds %zu bytes, %zu after the first\n", i+1,
+                   solver->context.arena.bytesreserved, reserved);
+            failures++;
+        }
+    }
+    if (reserved == 0)
+    {
+        printf("FAIL: the arena is given back after every request\n");
+        failures++;
+    }
+
+    P1DestroySolver(solver);
+    close(c.outfd);
+    pthread_mutex_destroy(&c.writelock);
+    printf("%s: %d requests, %zu arena bytes\n", failures ? "FAIL" : "PASS", REQUESTS, reserved);
+    return(failures ? 1 : 0);
+}